@@ -34,7 +34,9 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 namespace {
 
@@ -51,6 +53,10 @@ enum Switches {
     kSwitchWidth,
     kSwitchHeight,
     kSwitchOutput,
+
+    kSwitchIterations,
+
+    kSwitchImageThreads,
 };
 
 constexpr int kDefaultWidth = 768;
@@ -63,6 +69,8 @@ Flags::Flags()
 , width(kDefaultWidth)
 , height(kDefaultHeight)
 , output("headless.png")
+, iterations(1)
+, image_threads((int)std::max(1u, std::thread::hardware_concurrency()))
 {
 }
 
@@ -82,6 +90,10 @@ ParseStatus Flags::parse(int argc, char** argv)
         {"width", required_argument, nullptr, kSwitchWidth},
         {"height", required_argument, nullptr, kSwitchHeight},
         {"output", required_argument, nullptr, kSwitchOutput},
+
+        {"iterations", required_argument, nullptr, kSwitchIterations},
+
+        {"image-threads", required_argument, nullptr, kSwitchImageThreads},
         {nullptr, 0, nullptr}
     };
 
@@ -118,6 +130,14 @@ ParseStatus Flags::parse(int argc, char** argv)
                 output = optarg;
                 break;
 
+            case kSwitchIterations:
+                iterations = std::max(1, atoi(optarg));
+                break;
+
+            case kSwitchImageThreads:
+                image_threads = std::max(0, atoi(optarg));
+                break;
+
             default:
                 break;
         }
@@ -137,6 +157,8 @@ void Flags::usage(int exit_code)
     std::cout << "  ---width WIDTH              set the viewport to WIDTH pixels wide\n";
     std::cout << "  ---height HEIGHT            set the viewport to HEIGHT pixels wide\n";
     std::cout << "  ---output PNG               save the rendered web page to PNG\n";
+    std::cout << "  ---iterations N             load and render the web page N times and print timings\n";
+    std::cout << "  ---image-threads N          load images on N threads (0 loads them while parsing)\n";
     std::cout << std::endl;
 
     exit(exit_code);
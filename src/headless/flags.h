@@ -58,6 +58,10 @@ struct Flags {
     int height;
 
     std::string output;
+
+    int iterations;
+
+    int image_threads;
 };
 
 extern "C" const char* argv0;
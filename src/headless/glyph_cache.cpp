@@ -0,0 +1,152 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "glyph_cache.h"
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace headless {
+
+size_t GlyphCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = std::hash<const void*>()(key.face);
+    hash = hash * 31 + key.size;
+    hash = hash * 31 + key.glyph_index;
+    hash = hash * 31 + key.subpixel_x;
+    hash = hash * 31 + key.subpixel_y;
+    return hash;
+}
+
+GlyphCache::GlyphCache(size_t capacity)
+: capacity_(capacity)
+{
+}
+
+size_t GlyphCache::cost(const CachedGlyph& glyph)
+{
+    return sizeof(Entry) + sizeof(Key) + glyph.coverage.size();
+}
+
+const CachedGlyph& GlyphCache::get(FT_Face face, FT_UInt glyph_index, const FT_Vector& pen)
+{
+    // Only the fraction of a pixel the pen is at matters; the whole pixels
+    // are added when the glyph is drawn. Moving an outline by whole pixels
+    // moves its bitmap by the same pixels without changing it.
+    int subpixel_x = (int)(pen.x & 63);
+    int subpixel_y = (int)(pen.y & 63);
+
+    Key key = {face, face->size->metrics.y_ppem, glyph_index, subpixel_x, subpixel_y};
+
+    auto iterator = entries_.find(key);
+    if (iterator != entries_.end()) {
+        stats_.hits++;
+        lru_.splice(lru_.begin(), lru_, iterator->second.lru);
+        return iterator->second.glyph;
+    }
+
+    stats_.misses++;
+
+    // The transform is part of the face's state, so reset it for the other
+    // users of the face (e.g., HarfBuzz).
+    FT_Vector delta;
+    delta.x = subpixel_x;
+    delta.y = subpixel_y;
+    FT_Set_Transform(face, nullptr, &delta);
+    FT_Error error = FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER);
+    FT_Set_Transform(face, nullptr, nullptr);
+    if (error != 0) {
+        throw std::runtime_error("FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER)");
+    }
+
+    // For simplicity, assume that `bitmap.pixel_mode` is `FT_PIXEL_MODE_GRAY`
+    // (i.e., not a bitmap font).
+    const FT_GlyphSlot slot = face->glyph;
+    const FT_Bitmap& bitmap = slot->bitmap;
+
+    CachedGlyph glyph;
+    glyph.left = slot->bitmap_left;
+    glyph.top = slot->bitmap_top;
+    glyph.width = (int)bitmap.width;
+    glyph.rows = (int)bitmap.rows;
+    glyph.coverage.resize((size_t)glyph.width * glyph.rows);
+    for (int y = 0; y < glyph.rows; y++) {
+        memcpy(&glyph.coverage[(size_t)y * glyph.width],
+            bitmap.buffer + (ptrdiff_t)y * bitmap.pitch,
+            glyph.width);
+    }
+
+    size_ += cost(glyph);
+
+    lru_.push_front(key);
+    Entry& entry = entries_[key];
+    entry.glyph = std::move(glyph);
+    entry.lru = lru_.begin();
+
+    // Never evict the glyph that was just added.
+    while (size_ > capacity_ && lru_.size() > 1) {
+        evict();
+    }
+
+    return entry.glyph;
+}
+
+void GlyphCache::evict()
+{
+    auto iterator = entries_.find(lru_.back());
+    size_ -= cost(iterator->second.glyph);
+    entries_.erase(iterator);
+    lru_.pop_back();
+    stats_.evictions++;
+}
+
+void GlyphCache::remove(FT_Face face)
+{
+    for (auto iterator = lru_.begin(); iterator != lru_.end();) {
+        if (iterator->face == face) {
+            auto entry = entries_.find(*iterator);
+            size_ -= cost(entry->second.glyph);
+            entries_.erase(entry);
+            iterator = lru_.erase(iterator);
+        } else {
+            iterator++;
+        }
+    }
+}
+
+void GlyphCache::clear()
+{
+    entries_.clear();
+    lru_.clear();
+    size_ = 0;
+}
+
+} // namespace headless
@@ -0,0 +1,149 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef HEADLESS_GLYPH_CACHE_H__
+#define HEADLESS_GLYPH_CACHE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "freetype.h"
+
+namespace headless {
+
+// The coverage bitmap of a rendered glyph, one byte per pixel.
+struct CachedGlyph {
+    // The offset of the bitmap from the pen position, in whole pixels, with
+    // y pointing up (like FT_GlyphSlot::bitmap_left and bitmap_top).
+    int left = 0;
+    int top = 0;
+
+    int width = 0;
+    int rows = 0;
+
+    std::vector<uint8_t> coverage;
+};
+
+// Keeps the glyphs FreeType renders for draw_text(), so each glyph is only
+// rasterized once per face, size and position within a pixel (in 26.6 fixed
+// point, so the bitmaps are the same as rendering the glyph at the pen
+// position itself). The least recently used glyphs are dropped once the
+// bitmaps take more than the capacity.
+class GlyphCache {
+public:
+    static constexpr size_t kDefaultCapacity = 8 * 1024 * 1024;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+
+        double hit_rate() const
+        {
+            uint64_t lookups = hits + misses;
+            return lookups ? (double)hits / lookups : 0.0;
+        }
+    };
+
+private:
+    struct Key {
+        FT_Face face;
+        FT_UShort size;
+        FT_UInt glyph_index;
+        int subpixel_x;
+        int subpixel_y;
+
+        bool operator==(const Key& other) const
+        {
+            return face == other.face && size == other.size &&
+                   glyph_index == other.glyph_index &&
+                   subpixel_x == other.subpixel_x && subpixel_y == other.subpixel_y;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        CachedGlyph glyph;
+        std::list<Key>::iterator lru;
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> entries_;
+
+    // The keys from the most to the least recently used.
+    std::list<Key> lru_;
+
+    size_t capacity_;
+    size_t size_ = 0;
+
+    Stats stats_;
+
+    static size_t cost(const CachedGlyph& glyph);
+
+    void evict();
+
+public:
+    explicit GlyphCache(size_t capacity = kDefaultCapacity);
+
+    // Returns glyph_index of face rendered with the pen at pen (in 26.6
+    // fixed point) within its pixel, rendering it on a miss. The glyph is
+    // drawn at ((pen.x >> 6) + left, (pen.y >> 6) + top), with y pointing
+    // up. The returned glyph stays valid until the next call.
+    const CachedGlyph& get(FT_Face face, FT_UInt glyph_index, const FT_Vector& pen);
+
+    // Drops the glyphs of face, which is about to be destroyed.
+    void remove(FT_Face face);
+
+    void clear();
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    const Stats& stats() const
+    {
+        return stats_;
+    }
+};
+
+} // namespace headless
+
+#endif // HEADLESS_GLYPH_CACHE_H__
@@ -0,0 +1,127 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+
+#include "glyph_cache.h"
+
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace headless;
+
+namespace {
+
+class GlyphCacheTest : public testing::Test {
+protected:
+    FT_Library library_ = nullptr;
+    FT_Face face_ = nullptr;
+
+    void SetUp() override
+    {
+        ASSERT_EQ(0, FT_Init_FreeType(&library_));
+        std::string path = std::string(HEADLESS_FONTS_DIR) + "/Roboto-Regular.ttf";
+        ASSERT_EQ(0, FT_New_Face(library_, path.c_str(), 0, &face_));
+        ASSERT_EQ(0, FT_Set_Pixel_Sizes(face_, 0, 16));
+    }
+
+    void TearDown() override
+    {
+        FT_Done_Face(face_);
+        FT_Done_FreeType(library_);
+    }
+};
+
+} // namespace
+
+TEST_F(GlyphCacheTest, SameAsRenderingAtPen)
+{
+    // A cached glyph drawn at the whole pixels of the pen is the glyph
+    // FreeType renders with the pen as the transform.
+    GlyphCache cache;
+    std::mt19937 random(1);
+
+    for (int i = 0; i < 2000; i++) {
+        FT_UInt glyph_index = 1 + random() % 100;
+        FT_Vector pen;
+        pen.x = random() % (800 * 64);
+        pen.y = -(FT_Pos)(random() % (600 * 64));
+
+        CachedGlyph glyph = cache.get(face_, glyph_index, pen);
+
+        FT_Set_Transform(face_, nullptr, &pen);
+        ASSERT_EQ(0, FT_Load_Glyph(face_, glyph_index, FT_LOAD_RENDER));
+        FT_Set_Transform(face_, nullptr, nullptr);
+        const FT_GlyphSlot slot = face_->glyph;
+
+        ASSERT_EQ((int)slot->bitmap.width, glyph.width);
+        ASSERT_EQ((int)slot->bitmap.rows, glyph.rows);
+        if (glyph.width == 0 || glyph.rows == 0) {
+            continue;
+        }
+        EXPECT_EQ(slot->bitmap_left, (int)(pen.x >> 6) + glyph.left);
+        EXPECT_EQ(slot->bitmap_top, (int)(pen.y >> 6) + glyph.top);
+        for (int y = 0; y < glyph.rows; y++) {
+            ASSERT_EQ(0, memcmp(&glyph.coverage[(size_t)y * glyph.width],
+                slot->bitmap.buffer + (ptrdiff_t)y * slot->bitmap.pitch,
+                glyph.width));
+        }
+    }
+    EXPECT_GT(cache.stats().hits, 0u);
+}
+
+TEST_F(GlyphCacheTest, ResetsTransform)
+{
+    GlyphCache cache;
+    FT_Vector pen = {100 * 64 + 17, -50 * 64};
+    cache.get(face_, 36, pen);
+
+    FT_Matrix matrix;
+    FT_Vector delta;
+    FT_Get_Transform(face_, &matrix, &delta);
+    EXPECT_EQ(0, delta.x);
+    EXPECT_EQ(0, delta.y);
+    EXPECT_EQ(0x10000, matrix.xx);
+    EXPECT_EQ(0, matrix.xy);
+}
+
+TEST_F(GlyphCacheTest, Evict)
+{
+    // Only the most recently used glyphs fit.
+    GlyphCache cache(4096);
+    FT_Vector pen = {0, 0};
+    for (FT_UInt glyph_index = 1; glyph_index <= 100; glyph_index++) {
+        cache.get(face_, glyph_index, pen);
+    }
+    EXPECT_LE(cache.size(), cache.capacity());
+    EXPECT_GT(cache.stats().evictions, 0u);
+
+    uint64_t misses = cache.stats().misses;
+    cache.get(face_, 100, pen);
+    EXPECT_EQ(misses, cache.stats().misses);
+}
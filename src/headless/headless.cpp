@@ -26,8 +26,10 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include <fmt/format.h>
@@ -101,24 +103,69 @@ int main(int argc, char** argv)
 
     litehtml::Context ctx(master_stylesheet);
 
-    HeadlessContainer container(flags.font_directory, flags.width, flags.height);
-
-    std::unique_ptr<Document> document(DocumentParser::parse(
-        html,
-        url,
-        &container,
-        &ctx));
-
-    document->render(flags.width);
-
-    OrionRenderContext orc(document->width(), document->height());
-
-    orion::rasterizer_scanline_aa<> ras;
-    orion::scanline_p8 scanline;
-    ras.auto_close(false);
-
-    document->draw(reinterpret_cast<uintptr_t>(&orc), 0, 0, nullptr);
-    orc.canvas.save<PNGCodec>(flags.output);
+    HeadlessContainer container(flags.font_directory,
+        flags.width,
+        flags.height,
+        flags.image_threads);
+
+    // Each iteration parses, renders and draws the page from scratch (on a
+    // new canvas, so the saved image is the same however many times the page
+    // is drawn). The container, and so its caches, are shared.
+    std::unique_ptr<Document> document;
+    std::unique_ptr<OrionRenderContext> orc;
+    std::chrono::duration<double, std::milli> parse_time(0);
+    std::chrono::duration<double, std::milli> render_time(0);
+    std::chrono::duration<double, std::milli> draw_time(0);
+    for (int i = 0; i < flags.iterations; i++) {
+        document.reset();
+
+        auto start = std::chrono::steady_clock::now();
+        document.reset(DocumentParser::parse(html, url, &container, &ctx));
+        auto parsed = std::chrono::steady_clock::now();
+        document->render(flags.width);
+        auto rendered = std::chrono::steady_clock::now();
+
+        orc = std::make_unique<OrionRenderContext>(document->width(), document->height());
+
+        auto draw_start = std::chrono::steady_clock::now();
+        document->draw(reinterpret_cast<uintptr_t>(orc.get()), 0, 0, nullptr);
+        draw_time += std::chrono::steady_clock::now() - draw_start;
+        parse_time += parsed - start;
+        render_time += rendered - parsed;
+    }
+    orc->canvas.save<PNGCodec>(flags.output);
+
+    if (flags.iterations > 1) {
+        int n = flags.iterations;
+        std::cout << fmt::format("parse: {:.3f} ms, render: {:.3f} ms, draw: {:.3f} ms, total: {:.3f} ms ({} iterations)\n",
+            parse_time.count() / n,
+            render_time.count() / n,
+            draw_time.count() / n,
+            (parse_time + render_time + draw_time).count() / n,
+            n);
+
+        const GlyphCache::Stats& glyphs = container.glyph_cache_.stats();
+        std::cout << fmt::format("glyph cache: {:.1f}% hits ({} hits, {} misses, {} evictions, {} bytes)\n",
+            glyphs.hit_rate() * 100,
+            glyphs.hits,
+            glyphs.misses,
+            glyphs.evictions,
+            container.glyph_cache_.size());
+
+        ShapingCache::Stats shaping = container.shaping_cache_.stats();
+        std::cout << fmt::format("shaping cache: {:.1f}% hits ({} hits, {} misses, {} evictions)\n",
+            shaping.hit_rate() * 100,
+            shaping.hits,
+            shaping.misses,
+            shaping.evictions);
+
+        ImageLoader::Stats images = container.image_loader_.stats();
+        std::cout << fmt::format("images: {} fetched ({} bytes not decoded), {} decoded ({} bytes)\n",
+            images.fetched,
+            images.encoded_bytes,
+            images.decoded,
+            images.decoded_bytes);
+    }
 
 #if defined(ENABLE_JSON)
     std::ofstream ofs_stylesheet("stylesheet.json");
@@ -29,6 +29,7 @@
 
 #include "headless_container.h"
 
+#include <algorithm>
 #include <fstream>
 
 #include <fmt/format.h>
@@ -37,9 +38,10 @@
 #include <orion/rounded_rect.h>
 #include <utf8cpp/utf8.h>
 
+#include "glyph_cache.h"
 #include "http.h"
-#include "image/jpeg_codec.h"
-#include "image/png_codec.h"
+#include "image/composite.h"
+#include "image/draw_image.h"
 #include "litehtml/logging.h"
 #include "orion_render_context.h"
 
@@ -87,30 +89,24 @@ namespace {
 // We cannot use a higher DPI setting until media queries are implemented.
 constexpr int kDefaultDPI = 72;
 
-void draw_bitmap(Image<uint8_t>& canvas, FT_Bitmap* bitmap, Color color, FT_Int x, FT_Int y)
+void draw_glyph(Image<uint8_t>& canvas, const CachedGlyph& glyph, Color color, int x, int y)
 {
-    FT_Int x_max = x + bitmap->width;
-    FT_Int y_max = y + bitmap->rows;
+    // Clip the glyph to the canvas once rather than testing every pixel.
+    int p_min = std::max(0, -x);
+    int p_max = std::min(glyph.width, canvas.width() - x);
+    int q_min = std::max(0, -y);
+    int q_max = std::min(glyph.rows, canvas.height() - y);
 
-    // For simplicity, assume that `bitmap->pixel_mode` is `FT_PIXEL_MODE_GRAY`
-    // (i.e., not a bitmap font).
-
-    for (FT_Int i = x, p = 0; i < x_max; i++, p++) {
-        for (FT_Int j = y, q = 0; j < y_max; j++, q++) {
-            if (i < 0 || j < 0 || i >= canvas.width() || j >= canvas.height()) {
-                continue;
-            }
-
-            uint8_t* pixel = canvas.pixel(i, j);
-            uint8_t level = bitmap->buffer[q * bitmap->width + p];
+    if (p_min >= p_max) {
+        return;
+    }
 
-            // TODO: Optimize with SIMD?
-            // TODO: Figure out what this actually does -- are we blending here?
-            pixel[0] = ((pixel[0] * (255 - level)) + (level * color.red)) / 255;
-            pixel[1] = ((pixel[1] * (255 - level)) + (level * color.green)) / 255;
-            pixel[2] = ((pixel[2] * (255 - level)) + (level * color.blue)) / 255;
-            pixel[3] = pixel[3];
-        }
+    const uint8_t rgba[4] = {color.red, color.green, color.blue, color.alpha};
+    for (int q = q_min; q < q_max; q++) {
+        composite_mask_row(canvas.pixel(x + p_min, y + q),
+            &glyph.coverage[(size_t)q * glyph.width + p_min],
+            rgba,
+            p_max - p_min);
     }
 }
 
@@ -150,13 +146,15 @@ orion::rgba8 convert_color(const litehtml::Color& color)
 
 HeadlessContainer::HeadlessContainer(const std::filesystem::path& font_directory,
     int width,
-    int height)
+    int height,
+    int image_threads)
 : DocumentContainer()
 , font_directory_(font_directory)
 , default_font_path_(font_directory_ / "Roboto-Regular.ttf")
 , width_(width)
 , height_(height)
 , dpi_(kDefaultDPI)
+, image_loader_(image_threads)
 {
     FT_CALL(FT_Init_FreeType(&library_));
 
@@ -277,6 +275,8 @@ void HeadlessContainer::delete_font(uintptr_t hFont)
     HEADLESS_TRACE1(HeadlessContainer::delete_font, hFont);
 
     HeadlessFont* font = (HeadlessFont*)(hFont);
+    glyph_cache_.remove(font->ft_face);
+    shaping_cache_.remove(font);
     hb_font_destroy(font->hb_font);
     FT_CALL(FT_Done_Face(font->ft_face));
 }
@@ -292,32 +292,17 @@ int HeadlessContainer::text_width(const char* text,
     //
     // HEADLESS_TRACE1(HeadlessContainer::text_width, text);
 
-    HeadlessFont* font = (HeadlessFont*)(hFont);
-
-    hb_buffer_t* buffer = hb_buffer_create();
-    hb_buffer_add_utf8(buffer, text, -1, 0, -1);
-    hb_buffer_guess_segment_properties(buffer);
-
-    hb_shape(font->hb_font, buffer, nullptr, 0);
-
-    unsigned int glyph_count = 0;
-    hb_glyph_info_t* glyph_info = hb_buffer_get_glyph_infos(buffer, &glyph_count);
-    hb_glyph_position_t* glyph_positions = hb_buffer_get_glyph_positions(buffer, &glyph_count);
-
-    int width = 0;
+    return shaping_cache_.shape((HeadlessFont*)(hFont), text)->width;
+}
 
-    // FIXME: Handle RTL text.
-    for (unsigned int i = 0; i < glyph_count; ++i) {
-        width += glyph_positions[i].x_advance;
+void HeadlessContainer::measure_texts(const litehtml::TextRun* runs,
+    size_t count,
+    int* widths)
+{
+    // The shaped runs are kept for draw_text().
+    for (size_t i = 0; i < count; i++) {
+        widths[i] = shaping_cache_.shape((HeadlessFont*)(runs[i].font), runs[i].text)->width;
     }
-
-    hb_buffer_destroy(buffer);
-
-    // Convert from fractional pixels to whole pixels.
-    // TODO: Should we round the result rather than truncating the result?
-    width = width / 64;
-
-    return width;
 }
 
 void HeadlessContainer::draw_text(uintptr_t hdc,
@@ -339,15 +324,8 @@ void HeadlessContainer::draw_text(uintptr_t hdc,
 
     HeadlessFont* font = (HeadlessFont*)(hFont);
 
-    hb_buffer_t* buffer = hb_buffer_create();
-    hb_buffer_add_utf8(buffer, text, -1, 0, -1);
-    hb_buffer_guess_segment_properties(buffer);
-
-    hb_shape(font->hb_font, buffer, nullptr, 0);
-
-    unsigned int glyph_count = 0;
-    hb_glyph_info_t* glyph_info = hb_buffer_get_glyph_infos(buffer, &glyph_count);
-    hb_glyph_position_t* glyph_positions = hb_buffer_get_glyph_positions(buffer, &glyph_count);
+    // The text was most likely shaped when it was measured.
+    std::shared_ptr<const ShapedText> shaped = shaping_cache_.shape(font, text);
 
     // TODO: Should we round the result rather than truncating the result?
     int target_height = font->ft_face->size->metrics.height / 64;
@@ -359,7 +337,7 @@ void HeadlessContainer::draw_text(uintptr_t hdc,
     // pos.x and pos.y represent the upper left corner where the text should render
 
     // FIXME: Handle RTL text.
-    for (unsigned int i = 0; i < glyph_count; i++) {
+    for (const ShapedGlyph& shaped_glyph : shaped->glyphs) {
         // Stop rendering text if the pen falls outside the image bounds.
         // Otherwise FreeType may return a "raster overflow" error.  Given
         // that the FreeType documentation doesn't provide guidance on how to
@@ -368,23 +346,23 @@ void HeadlessContainer::draw_text(uintptr_t hdc,
             break;
         }
 
-        FT_UInt glyph_index = glyph_info[i].codepoint;
-        FT_GlyphSlot glyph = font->ft_face->glyph;
+        FT_UInt glyph_index = shaped_glyph.index;
 
-        FT_Set_Transform(font->ft_face, nullptr, &pen);
-        FT_CALL(FT_Load_Glyph(font->ft_face, glyph_index, FT_LOAD_RENDER));
+        // The glyph is rendered (once) at the fraction of a pixel the pen is
+        // at, and drawn at the whole pixels.
+        const CachedGlyph& glyph = glyph_cache_.get(font->ft_face, glyph_index, pen);
 
-        // target_height - glyph->bitmap_top effectively move the pen from the top
+        // target_height - glyph.top effectively move the pen from the top
         // of the line to the bottom of the line then backtrack to where the glyph starts.
 
-        draw_bitmap(canvas,
-            &glyph->bitmap,
+        draw_glyph(canvas,
+            glyph,
             color,
-            glyph->bitmap_left,
-            target_height - glyph->bitmap_top);
+            (int)(pen.x >> 6) + glyph.left,
+            target_height - glyph.top - (int)(pen.y >> 6));
 
-        pen.x += glyph_positions[i].x_advance;
-        pen.y += glyph_positions[i].y_advance;
+        pen.x += shaped_glyph.x_advance;
+        pen.y += shaped_glyph.y_advance;
     }
 }
 
@@ -408,41 +386,16 @@ void HeadlessContainer::load_image(const litehtml::URL& src, bool redraw_on_read
 {
     HEADLESS_TRACE1(HeadlessContainer::load_image, src.string());
 
-    std::string key = src.string();
-    auto iterator = image_cache_.find(key);
-    if (iterator != image_cache_.end()) {
-        return;
-    }
-
-    http_response response = http_request(src);
-
-    if (response.success()) {
-
-        // TODO: Find a way to log responses to disk for further inspection
-        // if necessary (e.g., to find out why our Image classes cannot decode
-        // certain images).
-
-        if (response.mime_type == "image/png") {
-            image_cache_[key] = PNGCodec::decompress((uint8_t*)response.body.data(), response.body.length(), kImageFormatRGBA);
-        } else if (response.mime_type == "image/jpeg") {
-            image_cache_[key] = JPEGCodec::decompress((uint8_t*)response.body.data(), response.body.length(), kImageFormatRGBA);
-        } else {
-            image_cache_[key] = Image<uint8_t>(16, 16, kImageFormatRGBA);
-        }
-    }
+    image_loader_.load(src);
 }
 
 litehtml::Size HeadlessContainer::get_image_size(const litehtml::URL& src)
 {
     HEADLESS_TRACE1(HeadlessContainer::get_image_size, src.string());
 
-    std::string key = src.string();
-    auto iterator = image_cache_.find(key);
-    if (iterator == image_cache_.end()) {
-        return litehtml::Size();
-    }
-
-    return litehtml::Size(iterator->second.width(), iterator->second.height());
+    // The size comes from the image's header; the image is decoded when it
+    // is first drawn.
+    return image_loader_.size(src.string());
 }
 
 void HeadlessContainer::draw_background(uintptr_t hdc,
@@ -487,36 +440,47 @@ void HeadlessContainer::draw_background(uintptr_t hdc,
     }
 
     std::string key = bg.image.string();
-    auto iterator = image_cache_.find(key);
-    if (iterator == image_cache_.end()) {
+    litehtml::Size size = image_loader_.size(key);
+    if (size.width <= 0 || size.height <= 0) {
         // TODO: Return a "broken image" placeholder (as other browsers do).
         return;
     }
 
-    // TODO: Check that all of the images are RGBA images.
-    // TODO: Use composite() here to draw the background image.
-    constexpr int channels = 4;
-
-    Image<uint8_t>& image = iterator->second;
-
-    // It's not clear how we should use the current clip_box variable when
-    // rendering the image.  For example, sometimes the background position
-    // variables (i.e., position_x and position_y) appear to be relative to
-    // clip_box.  Other times they appear to be absolute.  Other container
-    // implementations do not provide much guidance.
-
-    // For now assume the positions are absolute, not relative, as that seems
-    // to work well for most web pages.
+    // The position of the image is absolute: litehtml places it within
+    // origin_box, which is the viewport for a fixed image (and has scaled
+    // image_size for background-size).
+    ImageRect tile(bg.position_x,
+        bg.position_y,
+        bg.image_size.width > 0 ? bg.image_size.width : size.width,
+        bg.image_size.height > 0 ? bg.image_size.height : size.height);
+
+    bool repeat_x = bg.repeat == kBackgroundRepeatRepeat || bg.repeat == kBackgroundRepeatRepeatX;
+    bool repeat_y = bg.repeat == kBackgroundRepeatRepeat || bg.repeat == kBackgroundRepeatRepeatY;
+
+    // The image is clipped to the same rounded box as the background color,
+    // but its rounded edges are not anti-aliased.
+    ImageRect clip(bg.clip_box.x, bg.clip_box.y, bg.clip_box.width, bg.clip_box.height);
+    ImageRadii radii;
+    radii.top_left_x = bg.border_radii.top_left.x;
+    radii.top_left_y = bg.border_radii.top_left.y;
+    radii.top_right_x = bg.border_radii.top_right.x;
+    radii.top_right_y = bg.border_radii.top_right.y;
+    radii.bottom_right_x = bg.border_radii.bottom_right.x;
+    radii.bottom_right_y = bg.border_radii.bottom_right.y;
+    radii.bottom_left_x = bg.border_radii.bottom_left.x;
+    radii.bottom_left_y = bg.border_radii.bottom_left.y;
+
+    // Only decode the image once part of it is visible.
+    if (draw_image_bounds(canvas.width(), canvas.height(), tile, repeat_x, repeat_y, clip).empty()) {
+        return;
+    }
 
-    for (int y = 0; y < image.height(); y++) {
-        const uint8_t* src_row = image.row(y);
-        uint8_t* dst_row = canvas.row(y + bg.position_y) + (bg.position_x) * channels;
-        for (int x = 0; x < image.width(); x++) {
-            for (int c = 0; c < channels; c++) {
-                *dst_row++ = *src_row++;
-            }
-        }
+    // The image loader decodes every image to RGBA.
+    const Image<uint8_t>* image = image_loader_.get(key);
+    if (!image) {
+        return;
     }
+    draw_image(canvas, *image, tile, repeat_x, repeat_y, clip, radii);
 }
 
 class RoundedBorderPath {
@@ -34,8 +34,11 @@
 
 #include "font_description.h"
 #include "freetype.h"
+#include "glyph_cache.h"
 #include "headless_font.h"
 #include "image/image.h"
+#include "image_loader.h"
+#include "shaping_cache.h"
 #include "litehtml/litehtml.h"
 #include "litehtml/url.h"
 
@@ -65,14 +68,29 @@ public:
     // call draw_background() without a matching load_image() call).  For now
     // we assume it will not.
     //
-    // HeadlessContainer loads the images during load_image() and caches them in
-    // the image cache.  HeadlessContainer loads images from the image cache for
-    // get_image_size() and draw_background() calls.  HeadlessContainer will not
-    // attempt to load images in either get_image_size() or draw_background().
-
-    std::unordered_map<std::string, Image<uint8_t>> image_cache_;
-
-    HeadlessContainer(const std::filesystem::path&, int width, int height);
+    // HeadlessContainer starts loading the images during load_image(), on the
+    // image loader's threads, and keeps them in the image loader.
+    // get_image_size() and draw_background() wait for the image they need (if
+    // it is still loading).  get_image_size() only reads the size from the
+    // image's header; draw_background() decodes the image the first time it
+    // draws part of it.  HeadlessContainer will not attempt to load images
+    // that load_image() wasn't called for.
+
+    ImageLoader image_loader_;
+
+    // The glyphs draw_text() has rendered.
+    GlyphCache glyph_cache_;
+
+    // The strings text_width() and measure_texts() have shaped, for
+    // draw_text() to reuse.
+    ShapingCache shaping_cache_;
+
+    // Images are loaded on image_threads threads, or in load_image() if
+    // image_threads is 0.
+    HeadlessContainer(const std::filesystem::path&,
+        int width,
+        int height,
+        int image_threads = 0);
 
     virtual ~HeadlessContainer();
 
@@ -92,6 +110,10 @@ public:
     virtual int text_width(const char* text,
         uintptr_t hFont) override;
 
+    virtual void measure_texts(const litehtml::TextRun* runs,
+        size_t count,
+        int* widths) override;
+
     virtual void draw_text(uintptr_t hdc,
         const char* text,
         uintptr_t hFont,
@@ -36,6 +36,7 @@
 #include <stdint.h>
 
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -55,12 +56,10 @@ uint32_t write_callback(char* in, uint32_t size, uint32_t nmemb, std::string* ou
 
 http_response http_request(const litehtml::URL& url)
 {
-    static bool init_curl = false;
-
-    if (!init_curl) {
-        curl_global_init(CURL_GLOBAL_ALL);
-        init_curl = true;
-    }
+    // Images are fetched from several threads at once, and
+    // curl_global_init() isn't thread-safe.
+    static std::once_flag init_curl;
+    std::call_once(init_curl, [] { curl_global_init(CURL_GLOBAL_ALL); });
 
     http_response response;
 
@@ -80,9 +79,23 @@ http_response http_request(const litehtml::URL& url)
     CURLcode result = curl_easy_perform(curl);
     curl_easy_getinfo(curl, CURLINFO_HTTP_CODE, &response.code);
 
+    // Protocols other than HTTP (e.g., file URLs) have no response code.
+    if (result == CURLE_OK && response.code == 0) {
+        response.code = 200;
+    }
+
     if (result != CURLE_OK && result != CURLE_PARTIAL_FILE) {
         response.code = 0;
     }
 
+    char* content_type = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type);
+    if (content_type) {
+        response.mime_type = content_type;
+        response.mime_type = response.mime_type.substr(0, response.mime_type.find(';'));
+    }
+
+    curl_easy_cleanup(curl);
+
     return response;
 }
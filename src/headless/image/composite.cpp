@@ -31,11 +31,211 @@
 
 #include <assert.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "litehtml/logging.h"
 
 namespace headless {
 
-void composite(Image<uint8_t>& u, const Image<uint8_t>& v)
+namespace {
+
+// Returns x / 255 rounded to the nearest integer, for x from 0 to 255 * 255,
+// without dividing.
+inline unsigned int div255(unsigned int x)
+{
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+// Blends the color (r, g, b) with alpha over the pixel.  The result is
+// opaque where either is.
+inline void blend_pixel(uint8_t* pixel,
+  unsigned int r,
+  unsigned int g,
+  unsigned int b,
+  unsigned int alpha)
+{
+  unsigned int inverse_alpha = 255 - alpha;
+  pixel[0] = div255(r * alpha + pixel[0] * inverse_alpha);
+  pixel[1] = div255(g * alpha + pixel[1] * inverse_alpha);
+  pixel[2] = div255(b * alpha + pixel[2] * inverse_alpha);
+  pixel[3] = div255(255 * alpha + pixel[3] * inverse_alpha);
+}
+
+#if defined(__SSE2__)
+
+// Returns x / 255 rounded to the nearest integer for each 16-bit lane, like
+// div255() above.
+inline __m128i div255_epi16(__m128i x)
+{
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Blends the two pixels in s (with 16-bit channels, and 255 in place of
+// their alpha) with the alphas in a over the two pixels in d.
+inline __m128i blend_epi16(__m128i s, __m128i d, __m128i a)
+{
+  __m128i inverse_a = _mm_sub_epi16(_mm_set1_epi16(255), a);
+  return div255_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, inverse_a)));
+}
+
+// Returns the alpha of the two pixels in x (with 16-bit channels) in all of
+// their channels.
+inline __m128i broadcast_alpha_epi16(__m128i x)
+{
+  x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+#elif defined(__ARM_NEON)
+
+// Returns x / 255 rounded to the nearest integer for each 16-bit lane,
+// narrowed to 8 bits.
+inline uint8x8_t div255_u16(uint16x8_t x)
+{
+  x = vaddq_u16(x, vdupq_n_u16(128));
+  return vshrn_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+}
+
+// Blends the eight pixels of (r, g, b) with the alphas in a over the eight
+// pixels in d, one channel per vector.
+inline uint8x8x4_t blend_u8(uint8x8_t r, uint8x8_t g, uint8x8_t b, uint8x8_t a, uint8x8x4_t d)
+{
+  uint8x8_t inverse_a = vmvn_u8(a);
+  uint8x8x4_t result;
+  result.val[0] = div255_u16(vmlal_u8(vmull_u8(r, a), d.val[0], inverse_a));
+  result.val[1] = div255_u16(vmlal_u8(vmull_u8(g, a), d.val[1], inverse_a));
+  result.val[2] = div255_u16(vmlal_u8(vmull_u8(b, a), d.val[2], inverse_a));
+  result.val[3] = div255_u16(vmlal_u8(vmull_u8(vdup_n_u8(255), a), d.val[3], inverse_a));
+  return result;
+}
+
+#endif
+
+} // namespace
+
+void composite_row_reference(uint8_t* dst, const uint8_t* src, int count)
+{
+  for (int i = 0; i < count; i++) {
+    blend_pixel(dst, src[0], src[1], src[2], src[3]);
+    dst += 4;
+    src += 4;
+  }
+}
+
+void composite_row(uint8_t* dst, const uint8_t* src, int count)
+{
+  int i = 0;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+
+  // The channels of the source pixels, with 255 in place of their alpha, so
+  // the blended alpha is the source-over alpha.
+  const __m128i color_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+  const __m128i opaque = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+  for (; i + 4 <= count; i += 4) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+
+    __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+    __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+    __m128i a_lo = broadcast_alpha_epi16(s_lo);
+    __m128i a_hi = broadcast_alpha_epi16(s_hi);
+    s_lo = _mm_or_si128(_mm_and_si128(s_lo, color_mask), opaque);
+    s_hi = _mm_or_si128(_mm_and_si128(s_hi, color_mask), opaque);
+
+    __m128i lo = blend_epi16(s_lo, _mm_unpacklo_epi8(d, zero), a_lo);
+    __m128i hi = blend_epi16(s_hi, _mm_unpackhi_epi8(d, zero), a_hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 8 <= count; i += 8) {
+    uint8x8x4_t s = vld4_u8(src + i * 4);
+    uint8x8x4_t d = vld4_u8(dst + i * 4);
+    vst4_u8(dst + i * 4, blend_u8(s.val[0], s.val[1], s.val[2], s.val[3], d));
+  }
+#endif
+
+  composite_row_reference(dst + i * 4, src + i * 4, count - i);
+}
+
+void composite_mask_row_reference(uint8_t* dst,
+  const uint8_t* coverage,
+  const uint8_t color[4],
+  int count)
+{
+  for (int i = 0; i < count; i++) {
+    if (coverage[i] != 0) {
+      blend_pixel(dst, color[0], color[1], color[2], div255(coverage[i] * color[3]));
+    }
+    dst += 4;
+  }
+}
+
+void composite_mask_row(uint8_t* dst,
+  const uint8_t* coverage,
+  const uint8_t color[4],
+  int count)
+{
+  int i = 0;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i color_alpha = _mm_set1_epi16(color[3]);
+  const __m128i s = _mm_set_epi16(255, color[2], color[1], color[0], 255, color[2], color[1], color[0]);
+
+  for (; i + 4 <= count; i += 4) {
+    int32_t levels;
+    memcpy(&levels, coverage + i, sizeof(levels));
+
+    // Glyphs are mostly empty space.
+    if (levels == 0) {
+      continue;
+    }
+
+    // The alpha of each of the four pixels, in all four of their channels.
+    __m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128(levels), zero);
+    a = div255_epi16(_mm_mullo_epi16(a, color_alpha));
+    a = _mm_unpacklo_epi16(a, a);
+    __m128i a_lo = _mm_unpacklo_epi32(a, a);
+    __m128i a_hi = _mm_unpackhi_epi32(a, a);
+
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+    __m128i lo = blend_epi16(s, _mm_unpacklo_epi8(d, zero), a_lo);
+    __m128i hi = blend_epi16(s, _mm_unpackhi_epi8(d, zero), a_hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+  }
+#elif defined(__ARM_NEON)
+  const uint8x8_t r = vdup_n_u8(color[0]);
+  const uint8x8_t g = vdup_n_u8(color[1]);
+  const uint8x8_t b = vdup_n_u8(color[2]);
+  const uint8x8_t color_alpha = vdup_n_u8(color[3]);
+
+  for (; i + 8 <= count; i += 8) {
+    uint8x8_t levels = vld1_u8(coverage + i);
+
+    // Glyphs are mostly empty space.
+    if (vget_lane_u64(vreinterpret_u64_u8(levels), 0) == 0) {
+      continue;
+    }
+
+    uint8x8_t a = div255_u16(vmull_u8(levels, color_alpha));
+    uint8x8x4_t d = vld4_u8(dst + i * 4);
+    vst4_u8(dst + i * 4, blend_u8(r, g, b, a, d));
+  }
+#endif
+
+  composite_mask_row_reference(dst + i * 4, coverage + i, color, count - i);
+}
+
+void composite_reference(Image<uint8_t>& u, const Image<uint8_t>& v)
 {
   // The other image must have an alpha channel.
   assert(v.format() == kImageFormatRGBA);
@@ -43,7 +243,6 @@ void composite(Image<uint8_t>& u, const Image<uint8_t>& v)
   const int width = std::min(u.width(), v.width());
   const int height = std::min(u.height(), v.height());
   const int channels = u.channels();
-  const int other_channels = v.channels();
 
   for (int y = 0; y < height; y++) {
     const uint8_t* other_row = v.row(y);
@@ -53,14 +252,34 @@ void composite(Image<uint8_t>& u, const Image<uint8_t>& v)
       unsigned int alpha = other_row[3];
       unsigned int inverse_alpha = 255 - alpha;
       for (int c = 0; c < std::min(channels, 3); c++) {
-        unsigned int tmp = (other_row[c] * alpha + this_row[c] * inverse_alpha) / 255;
-        this_row[c] = tmp;
+        this_row[c] = div255(other_row[c] * alpha + this_row[c] * inverse_alpha);
+      }
+      if (channels == 4) {
+        this_row[3] = div255(255 * alpha + this_row[3] * inverse_alpha);
       }
 
       this_row += channels;
-      other_row += other_channels;
+      other_row += 4;
     }
   }
 }
 
+void composite(Image<uint8_t>& u, const Image<uint8_t>& v)
+{
+  // The other image must have an alpha channel.
+  assert(v.format() == kImageFormatRGBA);
+
+  if (u.format() != kImageFormatRGBA) {
+    composite_reference(u, v);
+    return;
+  }
+
+  const int width = std::min(u.width(), v.width());
+  const int height = std::min(u.height(), v.height());
+
+  for (int y = 0; y < height; y++) {
+    composite_row(u.row(y), v.row(y), width);
+  }
+}
+
 } // namespace headless
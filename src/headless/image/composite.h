@@ -30,14 +30,36 @@
 #ifndef HEADLESS_IMAGE_COMPOSITE_H__
 #define HEADLESS_IMAGE_COMPOSITE_H__
 
+#include <stdint.h>
+
 #include "image/image.h"
 
 namespace headless {
 
+// Blends v over u (source-over with straight alpha).  v must be an RGBA
+// image.  Only the area the two images have in common is blended.
 void composite(Image<uint8_t>& u, const Image<uint8_t>& v);
 
 void composite_reference(Image<uint8_t>& u, const Image<uint8_t>& v);
 
+// Blends count RGBA pixels from src over the RGBA pixels in dst.  Channels
+// are rounded to the nearest value, like composite_row_reference().
+void composite_row(uint8_t* dst, const uint8_t* src, int count);
+
+void composite_row_reference(uint8_t* dst, const uint8_t* src, int count);
+
+// Blends the RGBA color, with its alpha scaled by each of the count coverage
+// values (e.g., of an anti-aliased glyph), over the RGBA pixels in dst.
+void composite_mask_row(uint8_t* dst,
+  const uint8_t* coverage,
+  const uint8_t color[4],
+  int count);
+
+void composite_mask_row_reference(uint8_t* dst,
+  const uint8_t* coverage,
+  const uint8_t color[4],
+  int count);
+
 } // namespace headless
 
 #endif // HEADLESS_IMAGE_COMPOSITE_H__
\ No newline at end of file
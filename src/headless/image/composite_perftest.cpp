@@ -0,0 +1,116 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "image/composite.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+using namespace headless;
+
+namespace {
+
+constexpr int kWidth = 1024;
+
+std::vector<uint8_t> random_bytes(size_t count)
+{
+  std::mt19937 random(1);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(count);
+  for (uint8_t& byte : bytes) {
+    byte = distribution(random);
+  }
+  return bytes;
+}
+
+// Returns a row of glyph-like coverage: runs of empty, partial and full
+// coverage.
+std::vector<uint8_t> coverage_row()
+{
+  std::vector<uint8_t> coverage = random_bytes(kWidth);
+  for (int i = 0; i < kWidth; i++) {
+    switch ((i / 6) % 3) {
+      case 0:
+        coverage[i] = 0;
+        break;
+      case 1:
+        coverage[i] = 255;
+        break;
+    }
+  }
+  return coverage;
+}
+
+} // namespace
+
+// Blend a row of RGBA pixels over another, with the vector kernel (0) or the
+// scalar reference (1).
+void CompositePerfTestRow(benchmark::State& state)
+{
+  std::vector<uint8_t> src = random_bytes(kWidth * 4);
+  std::vector<uint8_t> dst = random_bytes(kWidth * 4);
+
+  for (auto _ : state) {
+    if (state.range(0) == 0) {
+      composite_row(dst.data(), src.data(), kWidth);
+    } else {
+      composite_row_reference(dst.data(), src.data(), kWidth);
+    }
+    benchmark::DoNotOptimize(dst.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * kWidth);
+}
+
+BENCHMARK(CompositePerfTestRow)->Arg(0)->Arg(1);
+
+// Blend a solid color through a row of glyph coverage, with the vector
+// kernel (0) or the scalar reference (1).
+void CompositePerfTestMaskRow(benchmark::State& state)
+{
+  std::vector<uint8_t> coverage = coverage_row();
+  std::vector<uint8_t> dst = random_bytes(kWidth * 4);
+  const uint8_t color[4] = {20, 40, 60, 255};
+
+  for (auto _ : state) {
+    if (state.range(0) == 0) {
+      composite_mask_row(dst.data(), coverage.data(), color, kWidth);
+    } else {
+      composite_mask_row_reference(dst.data(), coverage.data(), color, kWidth);
+    }
+    benchmark::DoNotOptimize(dst.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * kWidth);
+}
+
+BENCHMARK(CompositePerfTestMaskRow)->Arg(0)->Arg(1);
@@ -0,0 +1,151 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "image/composite.h"
+
+#include <math.h>
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace headless;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(std::mt19937& random, size_t count)
+{
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(count);
+  for (uint8_t& byte : bytes) {
+    byte = distribution(random);
+  }
+  return bytes;
+}
+
+} // namespace
+
+TEST(CompositeTest, Rounding)
+{
+  // An opaque pixel blended with a coverage of c over black comes out as
+  // round(c * channel / 255).
+  for (int level = 0; level < 256; level++) {
+    for (int channel = 0; channel < 256; channel++) {
+      uint8_t pixel[4] = {0, 0, 0, 255};
+      uint8_t coverage = level;
+      uint8_t color[4] = {(uint8_t)channel, 0, 0, 255};
+      composite_mask_row_reference(pixel, &coverage, color, 1);
+      ASSERT_EQ((int)lround(level * channel / 255.0), pixel[0]) << level << " " << channel;
+      ASSERT_EQ(255, pixel[3]);
+    }
+  }
+}
+
+TEST(CompositeTest, Row)
+{
+  std::mt19937 random(1);
+
+  // Cover the vector loops and the scalar tails, at every alignment.
+  for (int count = 0; count < 40; count++) {
+    for (int offset = 0; offset < 4; offset++) {
+      std::vector<uint8_t> src = random_bytes(random, (count + offset) * 4);
+      std::vector<uint8_t> dst = random_bytes(random, (count + offset) * 4);
+
+      // Include fully transparent and fully opaque pixels.
+      for (int i = 0; i < count; i += 3) {
+        src[(offset + i) * 4 + 3] = (i % 2) ? 255 : 0;
+      }
+
+      std::vector<uint8_t> expected = dst;
+      composite_row_reference(&expected[offset * 4], &src[offset * 4], count);
+      composite_row(&dst[offset * 4], &src[offset * 4], count);
+      ASSERT_EQ(expected, dst) << count << " " << offset;
+    }
+  }
+
+  uint8_t pixel[4] = {10, 20, 30, 40};
+  uint8_t transparent[4] = {200, 200, 200, 0};
+  composite_row(pixel, transparent, 1);
+  EXPECT_EQ(10, pixel[0]);
+  EXPECT_EQ(40, pixel[3]);
+
+  uint8_t opaque[4] = {200, 150, 100, 255};
+  composite_row(pixel, opaque, 1);
+  EXPECT_EQ(200, pixel[0]);
+  EXPECT_EQ(150, pixel[1]);
+  EXPECT_EQ(100, pixel[2]);
+  EXPECT_EQ(255, pixel[3]);
+}
+
+TEST(CompositeTest, MaskRow)
+{
+  std::mt19937 random(2);
+
+  for (int count = 0; count < 40; count++) {
+    for (int offset = 0; offset < 4; offset++) {
+      std::vector<uint8_t> coverage = random_bytes(random, count + offset);
+      std::vector<uint8_t> dst = random_bytes(random, (count + offset) * 4);
+      std::vector<uint8_t> color = random_bytes(random, 4);
+
+      // Include runs of empty coverage, which the vector loops skip.
+      for (int i = 0; i < count; i++) {
+        if ((i / 8) % 2) {
+          coverage[offset + i] = 0;
+        }
+      }
+
+      std::vector<uint8_t> expected = dst;
+      composite_mask_row_reference(&expected[offset * 4], &coverage[offset], color.data(), count);
+      composite_mask_row(&dst[offset * 4], &coverage[offset], color.data(), count);
+      ASSERT_EQ(expected, dst) << count << " " << offset;
+    }
+  }
+}
+
+TEST(CompositeTest, Image)
+{
+  std::mt19937 random(3);
+
+  Image<uint8_t> v(13, 7, kImageFormatRGBA);
+  std::vector<uint8_t> bytes = random_bytes(random, v.bytes());
+  memcpy(v.data(), bytes.data(), bytes.size());
+
+  for (ImageFormat format : {kImageFormatRGBA, kImageFormatRGB}) {
+    Image<uint8_t> u(11, 9, format);
+    bytes = random_bytes(random, u.bytes());
+    memcpy(u.data(), bytes.data(), bytes.size());
+
+    Image<uint8_t> expected = u;
+    composite_reference(expected, v);
+    composite(u, v);
+    EXPECT_EQ(0, memcmp(expected.data(), u.data(), u.bytes()));
+  }
+}
@@ -0,0 +1,219 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "image/draw_image.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "image/composite.h"
+
+namespace headless {
+
+namespace {
+
+// Returns a mod b, from 0 to b - 1 even for a negative a.
+int positive_mod(int a, int b)
+{
+  int result = a % b;
+  return result < 0 ? result + b : result;
+}
+
+bool is_opaque(const uint8_t* pixels, int count)
+{
+  for (int i = 0; i < count; i++) {
+    if (pixels[i * 4 + 3] != 255) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the half width of an ellipse with radii rx and ry at dy from its
+// centre, or 0 outside the ellipse.
+double ellipse_half_width(int rx, int ry, double dy)
+{
+  double t = dy / ry;
+  return t >= 1 ? 0 : rx * sqrt(1 - t * t);
+}
+
+// Narrows [x0, x1) to the pixels of row y whose centres are within the
+// corners of clip rounded by radii.
+void clip_row_to_radii(const ImageRect& clip,
+  const ImageRadii& radii,
+  int y,
+  int& x0,
+  int& x1)
+{
+  const double yc = y + 0.5;
+  const int top = clip.y;
+  const int bottom = clip.y + clip.height;
+  const int left = clip.x;
+  const int right = clip.x + clip.width;
+
+  // The pixels from x0 are within a left corner with its centre at cx if
+  // x0 + 0.5 >= cx - dx, and the pixels to x1 within a right corner if
+  // x1 - 0.5 <= cx + dx.
+  auto clip_left = [&](int rx, int ry, double dy) {
+    if (rx > 0 && ry > 0 && dy > 0) {
+      double dx = ellipse_half_width(rx, ry, dy);
+      x0 = std::max(x0, (int)ceil(left + rx - dx - 0.5));
+    }
+  };
+  auto clip_right = [&](int rx, int ry, double dy) {
+    if (rx > 0 && ry > 0 && dy > 0) {
+      double dx = ellipse_half_width(rx, ry, dy);
+      x1 = std::min(x1, (int)floor(right - rx + dx + 0.5));
+    }
+  };
+
+  clip_left(radii.top_left_x, radii.top_left_y, top + radii.top_left_y - yc);
+  clip_right(radii.top_right_x, radii.top_right_y, top + radii.top_right_y - yc);
+  clip_left(radii.bottom_left_x, radii.bottom_left_y, yc - (bottom - radii.bottom_left_y));
+  clip_right(radii.bottom_right_x, radii.bottom_right_y, yc - (bottom - radii.bottom_right_y));
+}
+
+} // namespace
+
+ImageRect draw_image_bounds(int canvas_width,
+  int canvas_height,
+  const ImageRect& tile,
+  bool repeat_x,
+  bool repeat_y,
+  const ImageRect& clip)
+{
+  if (tile.empty()) {
+    return ImageRect();
+  }
+
+  int x0 = std::max(clip.x, 0);
+  int x1 = std::min(clip.x + clip.width, canvas_width);
+  int y0 = std::max(clip.y, 0);
+  int y1 = std::min(clip.y + clip.height, canvas_height);
+  if (!repeat_x) {
+    x0 = std::max(x0, tile.x);
+    x1 = std::min(x1, tile.x + tile.width);
+  }
+  if (!repeat_y) {
+    y0 = std::max(y0, tile.y);
+    y1 = std::min(y1, tile.y + tile.height);
+  }
+  if (x0 >= x1 || y0 >= y1) {
+    return ImageRect();
+  }
+
+  return ImageRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void draw_image(Image<uint8_t>& canvas,
+  const Image<uint8_t>& image,
+  const ImageRect& tile,
+  bool repeat_x,
+  bool repeat_y,
+  const ImageRect& clip,
+  const ImageRadii& radii)
+{
+  assert(canvas.format() == kImageFormatRGBA);
+  assert(image.format() == kImageFormatRGBA);
+
+  if (image.width() <= 0 || image.height() <= 0) {
+    return;
+  }
+
+  ImageRect bounds = draw_image_bounds(canvas.width(), canvas.height(), tile, repeat_x, repeat_y, clip);
+  if (bounds.empty()) {
+    return;
+  }
+  const int x0 = bounds.x;
+  const int x1 = bounds.x + bounds.width;
+  const int y0 = bounds.y;
+  const int y1 = bounds.y + bounds.height;
+
+  // Scaled rows are built once per source row, from the source column of
+  // each tile column.
+  const bool scaled = tile.width != image.width();
+  std::vector<int> source_x;
+  std::vector<uint8_t> scaled_row;
+  if (scaled) {
+    source_x.resize(tile.width);
+    for (int i = 0; i < tile.width; i++) {
+      source_x[i] = (int)((int64_t)i * image.width() / tile.width);
+    }
+    scaled_row.resize((size_t)tile.width * 4);
+  }
+
+  int last_source_y = -1;
+  const uint8_t* tile_row = nullptr;
+  bool opaque = false;
+
+  for (int y = y0; y < y1; y++) {
+    int tile_y = positive_mod(y - tile.y, tile.height);
+    int source_y = (int)((int64_t)tile_y * image.height() / tile.height);
+
+    if (source_y != last_source_y) {
+      const uint8_t* source_row = image.row(source_y);
+      if (scaled) {
+        for (int i = 0; i < tile.width; i++) {
+          memcpy(&scaled_row[(size_t)i * 4], source_row + source_x[i] * 4, 4);
+        }
+        tile_row = scaled_row.data();
+      } else {
+        tile_row = source_row;
+      }
+      opaque = is_opaque(tile_row, tile.width);
+      last_source_y = source_y;
+    }
+
+    int row_x0 = x0;
+    int row_x1 = x1;
+    clip_row_to_radii(clip, radii, y, row_x0, row_x1);
+
+    // Draw the row a tile span at a time.
+    uint8_t* canvas_row = canvas.row(y);
+    int x = row_x0;
+    int tile_x = positive_mod(row_x0 - tile.x, tile.width);
+    while (x < row_x1) {
+      int count = std::min(tile.width - tile_x, row_x1 - x);
+      if (opaque) {
+        memcpy(canvas_row + x * 4, tile_row + tile_x * 4, (size_t)count * 4);
+      } else {
+        composite_row(canvas_row + x * 4, tile_row + tile_x * 4, count);
+      }
+      x += count;
+      tile_x = 0;
+    }
+  }
+}
+
+} // namespace headless
@@ -0,0 +1,98 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef HEADLESS_IMAGE_DRAW_IMAGE_H__
+#define HEADLESS_IMAGE_DRAW_IMAGE_H__
+
+#include "image/image.h"
+
+namespace headless {
+
+struct ImageRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+
+  ImageRect() = default;
+
+  ImageRect(int x, int y, int width, int height)
+  : x(x)
+  , y(y)
+  , width(width)
+  , height(height)
+  {
+  }
+
+  bool empty() const
+  {
+    return width <= 0 || height <= 0;
+  }
+};
+
+// The horizontal and vertical radii of the corners of a clip rectangle.
+struct ImageRadii {
+  int top_left_x = 0;
+  int top_left_y = 0;
+  int top_right_x = 0;
+  int top_right_y = 0;
+  int bottom_right_x = 0;
+  int bottom_right_y = 0;
+  int bottom_left_x = 0;
+  int bottom_left_y = 0;
+};
+
+// Returns the pixels of a canvas_width x canvas_height canvas that
+// draw_image() would draw with these arguments: the clip within the canvas,
+// and within the tile unless it repeats that way.  The rectangle is empty if
+// draw_image() would draw nothing, so callers can skip decoding the image.
+ImageRect draw_image_bounds(int canvas_width,
+  int canvas_height,
+  const ImageRect& tile,
+  bool repeat_x,
+  bool repeat_y,
+  const ImageRect& clip);
+
+// Draws image over canvas (both RGBA images), scaled (nearest neighbour) to
+// tile and repeated from there horizontally and/or vertically.  Only the
+// pixels within clip (with its corners rounded by radii) and the canvas are
+// touched; a pixel is within a rounded corner if its centre is.  Opaque
+// spans are copied, the others are blended with composite_row().
+void draw_image(Image<uint8_t>& canvas,
+  const Image<uint8_t>& image,
+  const ImageRect& tile,
+  bool repeat_x,
+  bool repeat_y,
+  const ImageRect& clip,
+  const ImageRadii& radii = ImageRadii());
+
+} // namespace headless
+
+#endif // HEADLESS_IMAGE_DRAW_IMAGE_H__
@@ -0,0 +1,101 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "image/draw_image.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace headless;
+
+namespace {
+
+Image<uint8_t> pattern_image(int width, int height, bool opaque)
+{
+  Image<uint8_t> image(width, height, kImageFormatRGBA);
+  for (int i = 0; i < image.bytes(); i++) {
+    image.data()[i] = (i % 4 == 3 && opaque) ? 255 : (uint8_t)(i * 7);
+  }
+  return image;
+}
+
+} // namespace
+
+// Tile a 64x64 image over a 1920x1080 background, opaque (state.range(0) ==
+// 0) or with alpha (1).
+void DrawImagePerfTestTiled(benchmark::State& state)
+{
+  Image<uint8_t> canvas(1920, 1080, kImageFormatRGBA);
+  Image<uint8_t> image = pattern_image(64, 64, state.range(0) == 0);
+
+  ImageRect clip(0, 0, canvas.width(), canvas.height());
+  for (auto _ : state) {
+    draw_image(canvas, image, ImageRect(10, 10, 64, 64), true, true, clip);
+    benchmark::DoNotOptimize(canvas.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * canvas.width() * canvas.height());
+}
+
+BENCHMARK(DrawImagePerfTestTiled)->Arg(0)->Arg(1);
+
+// Tile a page-sized background (1920x20000) clipped to a 1920x200 strip, as
+// when a small element has a large tiled background.
+void DrawImagePerfTestTiledClipped(benchmark::State& state)
+{
+  Image<uint8_t> canvas(1920, 20000, kImageFormatRGBA);
+  Image<uint8_t> image = pattern_image(64, 64, false);
+
+  ImageRect clip(0, 10000, canvas.width(), 200);
+  for (auto _ : state) {
+    draw_image(canvas, image, ImageRect(0, 0, 64, 64), true, true, clip);
+    benchmark::DoNotOptimize(canvas.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * clip.width * clip.height);
+}
+
+BENCHMARK(DrawImagePerfTestTiledClipped);
+
+// Draw a 256x256 image scaled up to 1024x1024.
+void DrawImagePerfTestScaled(benchmark::State& state)
+{
+  Image<uint8_t> canvas(1024, 1024, kImageFormatRGBA);
+  Image<uint8_t> image = pattern_image(256, 256, true);
+
+  ImageRect clip(0, 0, canvas.width(), canvas.height());
+  for (auto _ : state) {
+    draw_image(canvas, image, ImageRect(0, 0, 1024, 1024), false, false, clip);
+    benchmark::DoNotOptimize(canvas.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * canvas.width() * canvas.height());
+}
+
+BENCHMARK(DrawImagePerfTestScaled);
@@ -0,0 +1,248 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "image/draw_image.h"
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "image/composite.h"
+
+using namespace headless;
+
+namespace {
+
+Image<uint8_t> solid_image(int width, int height, uint8_t value, uint8_t alpha = 255)
+{
+  Image<uint8_t> image(width, height, kImageFormatRGBA);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t* pixel = image.pixel(x, y);
+      pixel[0] = pixel[1] = pixel[2] = value;
+      pixel[3] = alpha;
+    }
+  }
+  return image;
+}
+
+// Returns true if the centre of pixel (x, y) is outside the corner of an
+// ellipse with radii rx and ry and its centre at (cx, cy), on the side of
+// the centre that sx and sy point to.
+bool outside_corner(int x, int y, int cx, int cy, int rx, int ry, int sx, int sy)
+{
+  if (rx <= 0 || ry <= 0) {
+    return false;
+  }
+  double dx = (x + 0.5 - cx) * sx;
+  double dy = (y + 0.5 - cy) * sy;
+  if (dx <= 0 || dy <= 0) {
+    return false;
+  }
+  return (dx * dx) / ((double)rx * rx) + (dy * dy) / ((double)ry * ry) > 1;
+}
+
+// Draws image like draw_image(), a pixel at a time.
+void draw_image_reference(Image<uint8_t>& canvas,
+  const Image<uint8_t>& image,
+  const ImageRect& tile,
+  bool repeat_x,
+  bool repeat_y,
+  const ImageRect& clip,
+  const ImageRadii& radii = ImageRadii())
+{
+  const int left = clip.x;
+  const int top = clip.y;
+  const int right = clip.x + clip.width;
+  const int bottom = clip.y + clip.height;
+
+  for (int y = std::max(clip.y, 0); y < std::min(clip.y + clip.height, canvas.height()); y++) {
+    for (int x = std::max(clip.x, 0); x < std::min(clip.x + clip.width, canvas.width()); x++) {
+      if (outside_corner(x, y, left + radii.top_left_x, top + radii.top_left_y,
+            radii.top_left_x, radii.top_left_y, -1, -1) ||
+          outside_corner(x, y, right - radii.top_right_x, top + radii.top_right_y,
+            radii.top_right_x, radii.top_right_y, 1, -1) ||
+          outside_corner(x, y, right - radii.bottom_right_x, bottom - radii.bottom_right_y,
+            radii.bottom_right_x, radii.bottom_right_y, 1, 1) ||
+          outside_corner(x, y, left + radii.bottom_left_x, bottom - radii.bottom_left_y,
+            radii.bottom_left_x, radii.bottom_left_y, -1, 1)) {
+        continue;
+      }
+      int tile_x = x - tile.x;
+      int tile_y = y - tile.y;
+      if (repeat_x) {
+        tile_x = ((tile_x % tile.width) + tile.width) % tile.width;
+      }
+      if (repeat_y) {
+        tile_y = ((tile_y % tile.height) + tile.height) % tile.height;
+      }
+      if (tile_x < 0 || tile_x >= tile.width || tile_y < 0 || tile_y >= tile.height) {
+        continue;
+      }
+      const uint8_t* source = image.pixel(tile_x * image.width() / tile.width,
+        tile_y * image.height() / tile.height);
+      composite_row_reference(canvas.pixel(x, y), source, 1);
+    }
+  }
+}
+
+} // namespace
+
+TEST(DrawImageTest, NoRepeat)
+{
+  Image<uint8_t> canvas = solid_image(4, 4, 0);
+  Image<uint8_t> image = solid_image(2, 2, 200);
+
+  draw_image(canvas, image, ImageRect(1, 1, 2, 2), false, false, ImageRect(0, 0, 4, 4));
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      bool inside = x >= 1 && x < 3 && y >= 1 && y < 3;
+      EXPECT_EQ(inside ? 200 : 0, canvas.pixel(x, y)[0]) << x << " " << y;
+    }
+  }
+}
+
+TEST(DrawImageTest, OutsideCanvas)
+{
+  // Neither the tile nor the clip fit in the canvas.
+  Image<uint8_t> canvas = solid_image(4, 4, 0);
+  Image<uint8_t> image = solid_image(10, 10, 200);
+
+  draw_image(canvas, image, ImageRect(-3, 2, 10, 10), false, false, ImageRect(-100, -100, 1000, 1000));
+  EXPECT_EQ(0, canvas.pixel(3, 1)[0]);
+  EXPECT_EQ(200, canvas.pixel(3, 2)[0]);
+  EXPECT_EQ(200, canvas.pixel(0, 3)[0]);
+
+  draw_image(canvas, image, ImageRect(100, 100, 10, 10), false, false, ImageRect(0, 0, 4, 4));
+  draw_image(canvas, image, ImageRect(0, 0, 10, 10), true, true, ImageRect(4, 0, 10, 10));
+}
+
+TEST(DrawImageTest, Repeat)
+{
+  Image<uint8_t> canvas = solid_image(5, 3, 0);
+  Image<uint8_t> image(2, 1, kImageFormatRGBA);
+  memcpy(image.pixel(0, 0), "\x0a\x0a\x0a\xff\x14\x14\x14\xff", 8);
+
+  // Tiles repeat to the left of the tile too, but only within the clip.
+  draw_image(canvas, image, ImageRect(1, 1, 2, 1), true, false, ImageRect(0, 0, 4, 3));
+  const int expected[] = {20, 10, 20, 10, 0};
+  for (int x = 0; x < 5; x++) {
+    EXPECT_EQ(0, canvas.pixel(x, 0)[0]);
+    EXPECT_EQ(expected[x], canvas.pixel(x, 1)[0]) << x;
+    EXPECT_EQ(0, canvas.pixel(x, 2)[0]);
+  }
+}
+
+TEST(DrawImageTest, RoundedClip)
+{
+  Image<uint8_t> canvas = solid_image(8, 8, 0);
+  Image<uint8_t> image = solid_image(1, 1, 200);
+
+  // A circle: only the corner pixels (whose centres are outside it) are
+  // left out of the top row.
+  ImageRadii radii;
+  radii.top_left_x = radii.top_left_y = 4;
+  radii.top_right_x = radii.top_right_y = 4;
+  radii.bottom_right_x = radii.bottom_right_y = 4;
+  radii.bottom_left_x = radii.bottom_left_y = 4;
+  draw_image(canvas, image, ImageRect(0, 0, 1, 1), true, true, ImageRect(0, 0, 8, 8), radii);
+
+  const int expected[] = {0, 0, 200, 200, 200, 200, 0, 0};
+  for (int x = 0; x < 8; x++) {
+    EXPECT_EQ(expected[x], canvas.pixel(x, 0)[0]) << x;
+    EXPECT_EQ(expected[x], canvas.pixel(x, 7)[0]) << x;
+    EXPECT_EQ(expected[x], canvas.pixel(0, x)[0]) << x;
+    EXPECT_EQ(200, canvas.pixel(x, 4)[0]) << x;
+  }
+}
+
+TEST(DrawImageTest, Bounds)
+{
+  // Clipped to the canvas and the tile.
+  ImageRect bounds = draw_image_bounds(100, 50, ImageRect(-10, 40, 30, 30), false, false, ImageRect(0, 0, 200, 200));
+  EXPECT_EQ(0, bounds.x);
+  EXPECT_EQ(40, bounds.y);
+  EXPECT_EQ(20, bounds.width);
+  EXPECT_EQ(10, bounds.height);
+
+  // A repeating tile fills the clip along that axis.
+  bounds = draw_image_bounds(100, 50, ImageRect(-10, 40, 30, 30), true, false, ImageRect(5, 0, 50, 200));
+  EXPECT_EQ(5, bounds.x);
+  EXPECT_EQ(40, bounds.y);
+  EXPECT_EQ(50, bounds.width);
+  EXPECT_EQ(10, bounds.height);
+
+  // Outside the canvas, outside the clip, or an empty tile.
+  EXPECT_TRUE(draw_image_bounds(100, 50, ImageRect(0, 50, 30, 30), true, false, ImageRect(0, 0, 200, 200)).empty());
+  EXPECT_TRUE(draw_image_bounds(100, 50, ImageRect(0, 0, 30, 30), true, true, ImageRect(10, 10, 0, 10)).empty());
+  EXPECT_TRUE(draw_image_bounds(100, 50, ImageRect(0, 0, 30, 0), true, true, ImageRect(0, 0, 100, 50)).empty());
+}
+
+TEST(DrawImageTest, Reference)
+{
+  std::mt19937 random(1);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<int> position(-20, 40);
+  std::uniform_int_distribution<int> size(1, 30);
+
+  for (int i = 0; i < 200; i++) {
+    Image<uint8_t> image(size(random), size(random), kImageFormatRGBA);
+    bool opaque = i % 2;
+    for (int j = 0; j < image.bytes(); j++) {
+      image.data()[j] = (opaque && j % 4 == 3) ? 255 : byte(random);
+    }
+
+    ImageRect tile(position(random), position(random), size(random), size(random));
+    ImageRect clip(position(random), position(random), size(random) * 2, size(random) * 2);
+    bool repeat_x = byte(random) % 2;
+    bool repeat_y = byte(random) % 2;
+
+    // Radii no larger than half the clip, as litehtml scales them.
+    ImageRadii radii;
+    if (i % 3 == 0) {
+      std::uniform_int_distribution<int> radius_x(0, clip.width / 2);
+      std::uniform_int_distribution<int> radius_y(0, clip.height / 2);
+      radii.top_left_x = radius_x(random);
+      radii.top_left_y = radius_y(random);
+      radii.top_right_x = radius_x(random);
+      radii.top_right_y = radius_y(random);
+      radii.bottom_right_x = radius_x(random);
+      radii.bottom_right_y = radius_y(random);
+      radii.bottom_left_x = radius_x(random);
+      radii.bottom_left_y = radius_y(random);
+    }
+
+    Image<uint8_t> canvas = solid_image(32, 24, 50, 200);
+    Image<uint8_t> expected = canvas;
+    draw_image(canvas, image, tile, repeat_x, repeat_y, clip, radii);
+    draw_image_reference(expected, image, tile, repeat_x, repeat_y, clip, radii);
+    ASSERT_EQ(0, memcmp(expected.data(), canvas.data(), canvas.bytes())) << i;
+  }
+}
@@ -274,6 +274,66 @@ Image<uint8_t> JPEGCodec::decompress(uint8_t* data, size_t length, ImageFormat f
   return image;
 }
 
+bool JPEGCodec::probe(const uint8_t* data, size_t length, int* width, int* height)
+{
+  if (length < 4 || data[0] != 0xff || data[1] != 0xd8) {
+    return false;
+  }
+
+  // Walk the segments after SOI until the frame header.
+  size_t offset = 2;
+  while (offset + 4 <= length) {
+    if (data[offset] != 0xff) {
+      return false;
+    }
+    uint8_t marker = data[offset + 1];
+    if (marker == 0xff) {
+      // Fill byte.
+      offset++;
+      continue;
+    }
+    offset += 2;
+
+    // TEM and RSTn have no segment; EOI and SOS mean there's no frame
+    // header to find.
+    if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) {
+      continue;
+    }
+    if (marker == 0xd9 || marker == 0xda) {
+      return false;
+    }
+
+    size_t segment_length = (data[offset] << 8) | data[offset + 1];
+    if (segment_length < 2) {
+      return false;
+    }
+
+    // SOF0 to SOF15, except DHT, JPG and DAC which share the range.  The
+    // segment length is followed by the precision, then the height and
+    // width.
+    if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+      if (offset + 7 > length) {
+        return false;
+      }
+      int h = (data[offset + 3] << 8) | data[offset + 4];
+      int w = (data[offset + 5] << 8) | data[offset + 6];
+
+      // A height of 0 is defined later, by a DNL marker.
+      if (w == 0 || h == 0) {
+        return false;
+      }
+
+      *width = w;
+      *height = h;
+      return true;
+    }
+
+    offset += segment_length;
+  }
+
+  return false;
+}
+
 void JPEGCodec::compress(Image<uint8_t>& image, uint8_t** data, size_t* length, int quality)
 {
   jpeg_compress_struct cinfo;
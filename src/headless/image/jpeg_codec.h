@@ -40,6 +40,11 @@ class JPEGCodec {
 public:
   static Image<uint8_t> decompress(uint8_t* data, size_t length, ImageFormat format = kImageFormatRGB);
 
+  // Reads the width and height of the image from its frame header (SOF
+  // marker), without decoding the image.  Returns false if data doesn't
+  // contain a frame header before the image data.
+  static bool probe(const uint8_t* data, size_t length, int* width, int* height);
+
   static void compress(Image<uint8_t>& image, uint8_t** data, size_t* length, int quality = 70);
 };
 
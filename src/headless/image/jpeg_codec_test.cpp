@@ -0,0 +1,67 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "image/jpeg_codec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+using namespace headless;
+
+TEST(JPEGCodecTest, Probe)
+{
+  Image<uint8_t> image(37, 21, kImageFormatRGB);
+  memset(image.data(), 128, image.bytes());
+
+  uint8_t* data = nullptr;
+  size_t length = 0;
+  JPEGCodec::compress(image, &data, &length);
+
+  int width = 0;
+  int height = 0;
+  EXPECT_TRUE(JPEGCodec::probe(data, length, &width, &height));
+  EXPECT_EQ(37, width);
+  EXPECT_EQ(21, height);
+
+  Image<uint8_t> decoded = JPEGCodec::decompress(data, length, kImageFormatRGBA);
+  EXPECT_EQ(decoded.width(), width);
+  EXPECT_EQ(decoded.height(), height);
+
+  // Truncated, or not a JPEG at all.
+  EXPECT_FALSE(JPEGCodec::probe(data, 10, &width, &height));
+  EXPECT_FALSE(JPEGCodec::probe(data, 0, &width, &height));
+  data[1] = 'X';
+  EXPECT_FALSE(JPEGCodec::probe(data, length, &width, &height));
+
+  free(data);
+}
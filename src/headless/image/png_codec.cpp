@@ -30,6 +30,7 @@
 #include "image/png_codec.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include <algorithm>
 
@@ -298,6 +299,27 @@ Image<uint8_t> PNGCodec::decompress(uint8_t* data, size_t length, ImageFormat fo
   return image;
 }
 
+bool PNGCodec::probe(const uint8_t* data, size_t length, int* width, int* height)
+{
+  // The signature is followed by the IHDR chunk: its length, its type, then
+  // the width and height (big-endian).
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+  if (length < 24 || memcmp(data, kSignature, 8) != 0 || memcmp(data + 12, "IHDR", 4) != 0) {
+    return false;
+  }
+
+  uint32_t w = (uint32_t(data[16]) << 24) | (data[17] << 16) | (data[18] << 8) | data[19];
+  uint32_t h = (uint32_t(data[20]) << 24) | (data[21] << 16) | (data[22] << 8) | data[23];
+  if (w == 0 || h == 0 || w > 0x7fffffff || h > 0x7fffffff) {
+    return false;
+  }
+
+  *width = (int)w;
+  *height = (int)h;
+  return true;
+}
+
 void PNGCodec::compress(Image<uint8_t>& image, uint8_t** data, size_t* length)
 {
   png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
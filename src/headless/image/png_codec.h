@@ -40,6 +40,11 @@ class PNGCodec {
 public:
   static Image<uint8_t> decompress(uint8_t* data, size_t length, ImageFormat format = kImageFormatDefault);
 
+  // Reads the width and height of the image from its IHDR chunk, without
+  // decoding the image.  Returns false if data doesn't start with a PNG
+  // header.
+  static bool probe(const uint8_t* data, size_t length, int* width, int* height);
+
   static void compress(Image<uint8_t>& image, uint8_t** data, size_t* length);
 };
 
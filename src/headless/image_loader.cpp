@@ -0,0 +1,320 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "image_loader.h"
+
+#include <exception>
+#include <string_view>
+
+#include "http.h"
+#include "image/jpeg_codec.h"
+#include "image/png_codec.h"
+#include "litehtml/logging.h"
+
+namespace headless {
+
+namespace {
+
+enum ImageType {
+    kImageTypeUnknown,
+    kImageTypePNG,
+    kImageTypeJPEG,
+};
+
+bool starts_with(const std::string& data, std::string_view prefix)
+{
+    return std::string_view(data).substr(0, prefix.size()) == prefix;
+}
+
+ImageType image_type(const http_response& response)
+{
+    // Not every http_request() reports a MIME type (file URLs have none), so
+    // fall back to the signature at the start of the image.
+    if (response.mime_type == "image/png"
+        || starts_with(response.body, std::string_view("\x89PNG\r\n\x1a\n", 8))) {
+        return kImageTypePNG;
+    }
+    if (response.mime_type == "image/jpeg"
+        || starts_with(response.body, "\xff\xd8\xff")) {
+        return kImageTypeJPEG;
+    }
+    return kImageTypeUnknown;
+}
+
+bool probe(ImageType type, const std::string& data, int* width, int* height)
+{
+    const uint8_t* bytes = (const uint8_t*)data.data();
+    switch (type) {
+        case kImageTypePNG:
+            return PNGCodec::probe(bytes, data.length(), width, height);
+        case kImageTypeJPEG:
+            return JPEGCodec::probe(bytes, data.length(), width, height);
+        default:
+            return false;
+    }
+}
+
+// Decodes data to RGBA, or returns an empty image if it can't.
+Image<uint8_t> decode_image(const litehtml::URL& url, std::string& data)
+{
+    uint8_t* bytes = (uint8_t*)data.data();
+
+    // TODO: Find a way to log responses to disk for further inspection if
+    // necessary (e.g., to find out why our Image classes cannot decode
+    // certain images).
+    try {
+        if (starts_with(data, std::string_view("\x89PNG\r\n\x1a\n", 8))) {
+            return PNGCodec::decompress(bytes, data.length(), kImageFormatRGBA);
+        }
+        if (starts_with(data, "\xff\xd8\xff")) {
+            return JPEGCodec::decompress(bytes, data.length(), kImageFormatRGBA);
+        }
+    } catch (const std::exception& e) {
+        LOG(ERROR) << url.string() << ": " << e.what();
+    }
+    return Image<uint8_t>();
+}
+
+} // namespace
+
+ImageLoader::ImageLoader(int threads)
+{
+    for (int i = 0; i < threads; i++) {
+        threads_.emplace_back(&ImageLoader::worker, this);
+    }
+}
+
+ImageLoader::~ImageLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    queued_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ImageLoader::load(const litehtml::URL& url)
+{
+    Entry* entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_ptr<Entry>& slot = entries_[url.string()];
+        if (slot) {
+            return;
+        }
+        slot.reset(new Entry());
+        entry = slot.get();
+        entry->url = url;
+
+        if (!threads_.empty()) {
+            queue_.push_back(entry);
+        } else {
+            entry->state = kStateFetching;
+        }
+    }
+
+    if (!threads_.empty()) {
+        queued_.notify_one();
+    } else {
+        fetch(entry);
+    }
+}
+
+ImageLoader::Entry* ImageLoader::fetched_entry(std::unique_lock<std::mutex>& lock,
+    const std::string& url)
+{
+    auto iterator = entries_.find(url);
+    if (iterator == entries_.end()) {
+        return nullptr;
+    }
+    Entry* entry = iterator->second.get();
+
+    // Rather than wait behind the images queued before this one, fetch it
+    // here.
+    if (entry->state == kStateQueued) {
+        entry->state = kStateFetching;
+        lock.unlock();
+        fetch(entry);
+        lock.lock();
+    }
+
+    done_.wait(lock, [entry] { return entry->state >= kStateFetched; });
+    return entry;
+}
+
+litehtml::Size ImageLoader::size(const std::string& url)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    Entry* entry = fetched_entry(lock, url);
+    if (!entry || !entry->fetched) {
+        return litehtml::Size();
+    }
+    return litehtml::Size(entry->width, entry->height);
+}
+
+const Image<uint8_t>* ImageLoader::get(const std::string& url)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    Entry* entry = fetched_entry(lock, url);
+    if (!entry) {
+        return nullptr;
+    }
+
+    if (entry->state == kStateFetched) {
+        entry->state = kStateDecoding;
+        lock.unlock();
+        decode(entry);
+        lock.lock();
+    }
+
+    done_.wait(lock, [entry] { return entry->state == kStateDone; });
+    return entry->decoded ? &entry->image : nullptr;
+}
+
+void ImageLoader::wait()
+{
+    std::vector<std::string> urls;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : entries_) {
+            urls.push_back(entry.first);
+        }
+    }
+
+    for (const auto& url : urls) {
+        size(url);
+    }
+}
+
+ImageLoader::Stats ImageLoader::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ImageLoader::fetch(Entry* entry)
+{
+    http_response response = http_request(entry->url);
+    ImageType type = image_type(response);
+
+    int width = 0;
+    int height = 0;
+    bool probed = response.success() && probe(type, response.body, &width, &height);
+
+    // Images the codecs don't handle are drawn as a (blank) placeholder, and
+    // images whose header can't be read are decoded now for their size.
+    Image<uint8_t> image;
+    bool decoded = false;
+    if (response.success() && !probed) {
+        if (type == kImageTypeUnknown) {
+            image = Image<uint8_t>(16, 16, kImageFormatRGBA);
+        } else {
+            image = decode_image(entry->url, response.body);
+        }
+        decoded = image.width() > 0 && image.height() > 0;
+        width = image.width();
+        height = image.height();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry->fetched = probed || decoded;
+        entry->width = width;
+        entry->height = height;
+        if (probed) {
+            entry->data = std::move(response.body);
+            entry->state = kStateFetched;
+            stats_.encoded_bytes += entry->data.size();
+        } else {
+            entry->image = std::move(image);
+            entry->decoded = decoded;
+            entry->state = kStateDone;
+            if (decoded) {
+                stats_.decoded++;
+                stats_.decoded_bytes += entry->image.bytes();
+            }
+        }
+        if (entry->fetched) {
+            stats_.fetched++;
+        }
+    }
+    done_.notify_all();
+}
+
+void ImageLoader::decode(Entry* entry)
+{
+    // The data isn't touched by other threads while the entry is decoding.
+    Image<uint8_t> image = decode_image(entry->url, entry->data);
+    size_t encoded_bytes = entry->data.size();
+    std::string().swap(entry->data);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry->image = std::move(image);
+        entry->decoded = entry->image.width() > 0 && entry->image.height() > 0;
+        entry->state = kStateDone;
+        stats_.encoded_bytes -= encoded_bytes;
+        if (entry->decoded) {
+            stats_.decoded++;
+            stats_.decoded_bytes += entry->image.bytes();
+        }
+    }
+    done_.notify_all();
+}
+
+void ImageLoader::worker()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        queued_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (stop_) {
+            return;
+        }
+
+        Entry* entry = queue_.front();
+        queue_.pop_front();
+        if (entry->state != kStateQueued) {
+            continue;
+        }
+        entry->state = kStateFetching;
+
+        lock.unlock();
+        fetch(entry);
+        lock.lock();
+    }
+}
+
+} // namespace headless
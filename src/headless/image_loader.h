@@ -0,0 +1,175 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#ifndef HEADLESS_IMAGE_LOADER_H__
+#define HEADLESS_IMAGE_LOADER_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "image/image.h"
+#include "litehtml/types.h"
+#include "litehtml/url.h"
+
+namespace headless {
+
+// Fetches images on a set of worker threads, so the document parser can move
+// on as soon as it finds an image. Fetching an image only reads its size from
+// its header; the image is decoded the first time its pixels are needed, so
+// images that are never drawn are never decoded. A caller that needs an image
+// waits for that image alone, and fetches it itself if no worker has started
+// on it yet.
+class ImageLoader {
+public:
+    struct Stats {
+        // The images fetched, and the size of those not decoded yet.
+        size_t fetched = 0;
+        size_t encoded_bytes = 0;
+
+        // The images decoded, and the size of their pixels.
+        size_t decoded = 0;
+        size_t decoded_bytes = 0;
+    };
+
+private:
+    enum State {
+        kStateQueued,
+        kStateFetching,
+
+        // The size of the image is known, but it hasn't been decoded.
+        kStateFetched,
+
+        kStateDecoding,
+        kStateDone,
+    };
+
+    struct Entry {
+        litehtml::URL url;
+
+        State state = kStateQueued;
+
+        // Whether the image was fetched and its size read. Only read once
+        // state is kStateFetched or later, after which it doesn't change.
+        bool fetched = false;
+        int width = 0;
+        int height = 0;
+
+        // The image as fetched, until it is decoded.
+        std::string data;
+
+        // Whether the image was decoded. Only read once state is kStateDone,
+        // after which neither this nor image change.
+        bool decoded = false;
+
+        Image<uint8_t> image;
+    };
+
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+
+    // Signalled when an image is queued or the loader is destroyed.
+    std::condition_variable queued_;
+
+    // Signalled when an image is done.
+    std::condition_variable done_;
+
+    // Entries are never removed, so get() can hand out pointers to their
+    // images.
+    std::unordered_map<std::string, std::unique_ptr<Entry>> entries_;
+
+    // The entries waiting for a worker. An entry get() has started on stays
+    // here until a worker pops it and skips it.
+    std::deque<Entry*> queue_;
+
+    bool stop_ = false;
+
+    Stats stats_;
+
+    void worker();
+
+    // Returns the entry for url with its image fetched (fetching it on the
+    // calling thread if it is still queued), or nullptr if load() was never
+    // called for url.
+    Entry* fetched_entry(std::unique_lock<std::mutex>& lock, const std::string& url);
+
+    // Fetches the image of an entry the calling thread has moved to
+    // kStateFetching, and reads its size. Called without mutex_ held.
+    void fetch(Entry* entry);
+
+    // Decodes the image of an entry the calling thread has moved to
+    // kStateDecoding. Called without mutex_ held.
+    void decode(Entry* entry);
+
+public:
+    // Creates a loader with threads worker threads. A loader without worker
+    // threads loads every image in load().
+    explicit ImageLoader(int threads);
+
+    ~ImageLoader();
+
+    ImageLoader(const ImageLoader&) = delete;
+    ImageLoader& operator=(const ImageLoader&) = delete;
+
+    int threads() const
+    {
+        return (int)threads_.size();
+    }
+
+    // Starts loading the image at url, unless it was loaded before.
+    void load(const litehtml::URL& url);
+
+    // Returns the size of the image loaded from url, waiting for it to be
+    // fetched if it hasn't been, but not decoding it. Returns an empty size if
+    // load() was never called for url or the image couldn't be fetched.
+    litehtml::Size size(const std::string& url);
+
+    // Returns the image loaded from url, decoding it if it hasn't been
+    // decoded. Returns nullptr if load() was never called for url or the
+    // image couldn't be fetched or decoded.
+    const Image<uint8_t>* get(const std::string& url);
+
+    // Waits for every image load() has started to be fetched.
+    void wait();
+
+    Stats stats();
+};
+
+} // namespace headless
+
+#endif // HEADLESS_IMAGE_LOADER_H__
@@ -0,0 +1,103 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "image_loader.h"
+
+#include <filesystem>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "image/png_codec.h"
+
+using namespace headless;
+
+namespace {
+
+constexpr int kImages = 200;
+
+// The images of an image-heavy page: kImages distinct 256x256 PNGs.
+const std::vector<litehtml::URL>& page_images()
+{
+    static std::vector<litehtml::URL> urls;
+    if (urls.empty()) {
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "headless_image_loader_perftest";
+        std::filesystem::create_directories(directory);
+
+        Image<uint8_t> image(256, 256, kImageFormatRGBA);
+        for (int i = 0; i < kImages; i++) {
+            for (int j = 0; j < image.bytes(); j++) {
+                image.data()[j] = (uint8_t)((j / 4) * (i + 1) + j / 1024);
+            }
+            std::filesystem::path path = directory / (std::to_string(i) + ".png");
+            image.save<PNGCodec>(path.string());
+            urls.emplace_back("file", "", path.string(), "", "");
+        }
+    }
+    return urls;
+}
+
+} // namespace
+
+// Load the images of the page as the container does: load() for each image
+// as the parser finds it, size() for each as layout needs it, then get() for
+// the first state.range(1) images as they are drawn. state.range(0) is the
+// number of worker threads (0 fetches each image in load()).
+void ImageLoaderPerfTestPage(benchmark::State& state)
+{
+    const std::vector<litehtml::URL>& urls = page_images();
+    const size_t drawn = std::min(urls.size(), (size_t)state.range(1));
+
+    ImageLoader::Stats stats;
+    for (auto _ : state) {
+        ImageLoader loader((int)state.range(0));
+        for (const auto& url : urls) {
+            loader.load(url);
+        }
+        for (const auto& url : urls) {
+            benchmark::DoNotOptimize(loader.size(url.string()));
+        }
+        for (size_t i = 0; i < drawn; i++) {
+            benchmark::DoNotOptimize(loader.get(urls[i].string()));
+        }
+        stats = loader.stats();
+    }
+
+    state.SetItemsProcessed(state.iterations() * urls.size());
+    state.counters["decoded"] = (double)stats.decoded;
+    state.counters["encoded_bytes"] = (double)stats.encoded_bytes;
+    state.counters["decoded_bytes"] = (double)stats.decoded_bytes;
+}
+
+BENCHMARK(ImageLoaderPerfTestPage)
+    ->ArgsProduct({{0, 1, 2, 4, 8}, {kImages, kImages / 10}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
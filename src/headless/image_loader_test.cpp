@@ -0,0 +1,159 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "image_loader.h"
+
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "image/jpeg_codec.h"
+#include "image/png_codec.h"
+
+using namespace headless;
+
+namespace {
+
+std::filesystem::path test_directory()
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "headless_image_loader_test";
+    std::filesystem::create_directories(path);
+    return path;
+}
+
+// Saves a width x height image to path, filled with value.
+litehtml::URL save_image(const std::filesystem::path& path,
+    int width,
+    int height,
+    uint8_t value)
+{
+    Image<uint8_t> image(width, height, kImageFormatRGB);
+    memset(image.data(), value, image.bytes());
+    if (path.extension() == ".jpg") {
+        image.save<JPEGCodec>(path.string());
+    } else {
+        image.save<PNGCodec>(path.string());
+    }
+    return litehtml::URL("file", "", path.string(), "", "");
+}
+
+void test_load(int threads)
+{
+    std::filesystem::path directory = test_directory();
+
+    std::vector<litehtml::URL> urls;
+    for (int i = 0; i < 20; i++) {
+        std::string name = std::to_string(i) + (i % 4 == 0 ? ".jpg" : ".png");
+        urls.push_back(save_image(directory / name, i + 1, 2 * i + 1, i * 10));
+    }
+    litehtml::URL missing("file", "", (directory / "missing.png").string(), "", "");
+
+    ImageLoader loader(threads);
+    EXPECT_EQ(threads, loader.threads());
+    for (const auto& url : urls) {
+        loader.load(url);
+    }
+    loader.load(urls[0]);
+    loader.load(missing);
+
+    // Ask for the images in reverse, so some are still queued.
+    for (int i = (int)urls.size() - 1; i >= 0; i--) {
+        const Image<uint8_t>* image = loader.get(urls[i].string());
+        ASSERT_NE(nullptr, image) << i;
+        EXPECT_EQ(kImageFormatRGBA, image->format());
+        EXPECT_EQ(i + 1, image->width());
+        EXPECT_EQ(2 * i + 1, image->height());
+        if (i % 4 != 0) {
+            EXPECT_EQ(i * 10, image->pixel(0, 0)[0]);
+            EXPECT_EQ(255, image->pixel(0, 0)[3]);
+        }
+
+        // The same image is returned every time.
+        EXPECT_EQ(image, loader.get(urls[i].string()));
+    }
+
+    EXPECT_EQ(nullptr, loader.get(missing.string()));
+    EXPECT_EQ(nullptr, loader.get("file:///never/loaded.png"));
+
+    loader.wait();
+
+    ImageLoader::Stats stats = loader.stats();
+    EXPECT_EQ(urls.size(), stats.fetched);
+    EXPECT_EQ(urls.size(), stats.decoded);
+    EXPECT_EQ(0u, stats.encoded_bytes);
+}
+
+} // namespace
+
+TEST(ImageLoaderTest, Synchronous)
+{
+    test_load(0);
+}
+
+TEST(ImageLoaderTest, Threads)
+{
+    test_load(1);
+    test_load(4);
+}
+
+TEST(ImageLoaderTest, Lazy)
+{
+    std::filesystem::path directory = test_directory();
+    litehtml::URL png = save_image(directory / "lazy.png", 30, 20, 100);
+    litehtml::URL jpeg = save_image(directory / "lazy.jpg", 40, 10, 100);
+
+    ImageLoader loader(2);
+    loader.load(png);
+    loader.load(jpeg);
+
+    // The sizes come from the headers, without decoding the images.
+    EXPECT_EQ(30, loader.size(png.string()).width);
+    EXPECT_EQ(20, loader.size(png.string()).height);
+    EXPECT_EQ(40, loader.size(jpeg.string()).width);
+    EXPECT_EQ(10, loader.size(jpeg.string()).height);
+
+    ImageLoader::Stats stats = loader.stats();
+    EXPECT_EQ(2u, stats.fetched);
+    EXPECT_EQ(0u, stats.decoded);
+    EXPECT_EQ(0u, stats.decoded_bytes);
+    EXPECT_EQ(std::filesystem::file_size(directory / "lazy.png") + std::filesystem::file_size(directory / "lazy.jpg"),
+        stats.encoded_bytes);
+
+    const Image<uint8_t>* image = loader.get(png.string());
+    ASSERT_NE(nullptr, image);
+    EXPECT_EQ(30, image->width());
+    EXPECT_EQ(20, image->height());
+
+    stats = loader.stats();
+    EXPECT_EQ(1u, stats.decoded);
+    EXPECT_EQ(30u * 20 * 4, stats.decoded_bytes);
+    EXPECT_EQ(std::filesystem::file_size(directory / "lazy.jpg"), stats.encoded_bytes);
+}
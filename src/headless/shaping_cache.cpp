@@ -0,0 +1,132 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "shaping_cache.h"
+
+namespace headless {
+
+ShapingCache::ShapingCache(size_t capacity)
+: capacity_(capacity)
+, buffer_(hb_buffer_create())
+{
+}
+
+ShapingCache::~ShapingCache()
+{
+    hb_buffer_destroy(buffer_);
+}
+
+std::shared_ptr<const ShapedText> ShapingCache::shape(HeadlessFont* font, const char* text)
+{
+    Key key = {font, text};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto iterator = texts_.find(key);
+    if (iterator != texts_.end()) {
+        stats_.hits++;
+        lru_.splice(lru_.begin(), lru_, iterator->second.lru);
+        return iterator->second.shaped;
+    }
+    stats_.misses++;
+
+    hb_buffer_clear_contents(buffer_);
+    hb_buffer_add_utf8(buffer_, text, -1, 0, -1);
+    hb_buffer_guess_segment_properties(buffer_);
+
+    hb_shape(font->hb_font, buffer_, nullptr, 0);
+
+    unsigned int glyph_count = 0;
+    hb_glyph_info_t* glyph_info = hb_buffer_get_glyph_infos(buffer_, &glyph_count);
+    hb_glyph_position_t* glyph_positions = hb_buffer_get_glyph_positions(buffer_, &glyph_count);
+
+    auto shaped = std::make_shared<ShapedText>();
+    shaped->glyphs.resize(glyph_count);
+
+    int width = 0;
+
+    // FIXME: Handle RTL text.
+    for (unsigned int i = 0; i < glyph_count; i++) {
+        shaped->glyphs[i].index = glyph_info[i].codepoint;
+        shaped->glyphs[i].x_advance = glyph_positions[i].x_advance;
+        shaped->glyphs[i].y_advance = glyph_positions[i].y_advance;
+        width += glyph_positions[i].x_advance;
+    }
+
+    // Convert from fractional pixels to whole pixels.
+    // TODO: Should we round the result rather than truncating the result?
+    shaped->width = width / 64;
+
+    while (!lru_.empty() && texts_.size() >= capacity_) {
+        texts_.erase(lru_.back());
+        lru_.pop_back();
+        stats_.evictions++;
+    }
+
+    lru_.push_front(key);
+    Entry& entry = texts_[std::move(key)];
+    entry.shaped = shaped;
+    entry.lru = lru_.begin();
+    return shaped;
+}
+
+void ShapingCache::remove(const HeadlessFont* font)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto iterator = lru_.begin(); iterator != lru_.end();) {
+        if (iterator->font == font) {
+            texts_.erase(*iterator);
+            iterator = lru_.erase(iterator);
+        } else {
+            iterator++;
+        }
+    }
+}
+
+void ShapingCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    texts_.clear();
+    lru_.clear();
+}
+
+size_t ShapingCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return texts_.size();
+}
+
+ShapingCache::Stats ShapingCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace headless
@@ -0,0 +1,149 @@
+// Copyright (C) 2020-2025 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef HEADLESS_SHAPING_CACHE_H__
+#define HEADLESS_SHAPING_CACHE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "headless_font.h"
+
+namespace headless {
+
+struct ShapedGlyph {
+    hb_codepoint_t index;
+
+    // In 26.6 fixed point, like hb_glyph_position_t.
+    hb_position_t x_advance;
+    hb_position_t y_advance;
+};
+
+// The glyphs HarfBuzz shaped a string into.
+struct ShapedText {
+    std::vector<ShapedGlyph> glyphs;
+
+    // The sum of the advances, in whole pixels.
+    int width = 0;
+};
+
+// Remembers how strings were shaped in each font, so text_width() and
+// draw_text() shape each word once rather than once each. Like
+// litehtml::TextWidthCache, the least recently used strings are dropped
+// once the cache holds capacity strings. Shaping reuses one HarfBuzz buffer
+// rather than creating one per string.
+//
+// The cache may be used from several threads at once. Strings are shaped
+// while holding the cache's lock, as the fonts' hb_font_t and FT_Face
+// aren't safe to use from several threads at once.
+class ShapingCache {
+public:
+    static constexpr size_t kDefaultCapacity = 16384;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+
+        double hit_rate() const
+        {
+            uint64_t lookups = hits + misses;
+            return lookups ? (double)hits / lookups : 0.0;
+        }
+    };
+
+private:
+    struct Key {
+        const HeadlessFont* font;
+        std::string text;
+
+        bool operator==(const Key& other) const
+        {
+            return font == other.font && text == other.text;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<std::string>()(key.text) ^
+                   (std::hash<const void*>()(key.font) * 31);
+        }
+    };
+
+    struct Entry {
+        std::shared_ptr<const ShapedText> shaped;
+        std::list<Key>::iterator lru;
+    };
+
+    size_t capacity_;
+
+    mutable std::mutex mutex_;
+
+    std::unordered_map<Key, Entry, KeyHash> texts_;
+
+    // The keys from the most to the least recently used.
+    std::list<Key> lru_;
+
+    hb_buffer_t* buffer_;
+
+    Stats stats_;
+
+public:
+    explicit ShapingCache(size_t capacity = kDefaultCapacity);
+
+    ~ShapingCache();
+
+    ShapingCache(const ShapingCache&) = delete;
+    ShapingCache& operator=(const ShapingCache&) = delete;
+
+    // Returns text shaped in font, shaping it if it isn't cached.
+    std::shared_ptr<const ShapedText> shape(HeadlessFont* font, const char* text);
+
+    // Drops the strings shaped in font, which is about to be deleted.
+    void remove(const HeadlessFont* font);
+
+    void clear();
+
+    size_t size() const;
+
+    Stats stats() const;
+};
+
+} // namespace headless
+
+#endif // HEADLESS_SHAPING_CACHE_H__
@@ -36,19 +36,6 @@ namespace litehtml {
 
 Context::Context(const std::string& css)
 {
-    MediaQueryList::ptr media;
-
-    master_stylesheet_.parse(css,
-        URL(),
-        nullptr,
-        MediaQueryList::ptr());
-    master_stylesheet_.sort_selectors();
-}
-
-void Context::load_master_stylesheet(const std::string& css)
-{
-    MediaQueryList::ptr media;
-
     master_stylesheet_.parse(css,
         URL(),
         nullptr,
@@ -31,7 +31,13 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+#include <vector>
+
+#include "litehtml/document.h"
+#include "litehtml/document_parser.h"
 #include "litehtml/utf8_strings.h"
+#include "test_container.h"
 
 using namespace litehtml;
 
@@ -43,3 +49,60 @@ TEST(ContextTest, LoadMasterStylesheet)
 {
     Context ctx(master_css);
 }
+
+namespace {
+
+// A container with a window of the given width.
+class window_container : public test_container {
+    int width_;
+
+public:
+    explicit window_container(int width)
+    : width_(width)
+    {
+    }
+
+    virtual Position get_client_rect() const override
+    {
+        return Position(0, 0, width_, 600);
+    }
+};
+
+} // namespace
+
+TEST(ContextTest, SharedBetweenThreads)
+{
+    const Context context(master_css);
+
+    const char* html =
+        "<html><head><style media=\"(min-width: 500px)\">p { margin-left: 20px; }</style></head>"
+        "<body><p>Hello</p><table><tr><td>a</td><td>b</td></tr></table></body></html>";
+
+    // Each document evaluates the media queries against its own container.
+    auto render = [&context, html](int width) {
+        window_container container(width);
+        Document* document = DocumentParser::parse(html, URL(), &container, &context);
+        document->render(width);
+        int margin = document->root()->select_one("p")->margin().left;
+        delete document;
+        return margin;
+    };
+
+    EXPECT_EQ(0, render(400));
+    EXPECT_EQ(20, render(800));
+
+    std::vector<int> margins(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < margins.size(); i++) {
+        threads.emplace_back([&render, &margins, i]() {
+            margins[i] = render(i % 2 ? 800 : 400);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < margins.size(); i++) {
+        EXPECT_EQ(i % 2 ? 20 : 0, margins[i]);
+    }
+}
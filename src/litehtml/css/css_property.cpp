@@ -215,6 +215,8 @@ String css_property_string(CSSProperty property)
             return "position";
         case kCSSPropertyRight:
             return "right";
+        case kCSSPropertyTableLayout:
+            return "table-layout";
         case kCSSPropertyTextAlign:
             return "text-align";
         case kCSSPropertyTextDecoration:
@@ -509,6 +511,9 @@ CSSProperty css_property_from_string(const String& name)
     if (name == "right") {
         return kCSSPropertyRight;
     }
+    if (name == "table-layout") {
+        return kCSSPropertyTableLayout;
+    }
     if (name == "text-align") {
         return kCSSPropertyTextAlign;
     }
@@ -727,6 +732,8 @@ const char* css_property_default(CSSProperty property)
             return "static";
         case kCSSPropertyRight:
             return "auto";
+        case kCSSPropertyTableLayout:
+            return "auto";
         case kCSSPropertyTextAlign:
             return "left";
         case kCSSPropertyTextDecoration:
@@ -1112,6 +1119,10 @@ const CSSValue* css_property_default_value(CSSProperty property)
             static const CSSValue* default_value = CSSValue::factory(property, "auto", false);
             return default_value;
         }
+        case kCSSPropertyTableLayout: {
+            static const CSSValue* default_value = CSSValue::factory(property, "auto", false);
+            return default_value;
+        }
         case kCSSPropertyTextAlign: {
             static const CSSValue* default_value = CSSValue::factory(property, "left", false);
             return default_value;
@@ -1344,6 +1355,8 @@ bool css_property_inherited(CSSProperty property)
             return false;
         case kCSSPropertyRight:
             return false;
+        case kCSSPropertyTableLayout:
+            return false;
         case kCSSPropertyTextAlign:
             return true;
         case kCSSPropertyTextDecoration:
@@ -1553,6 +1566,8 @@ CSSValueType css_property_value_type(CSSProperty property)
             return kCSSValueKeyword;
         case kCSSPropertyRight:
             return kCSSValueLength;
+        case kCSSPropertyTableLayout:
+            return kCSSValueKeyword;
         case kCSSPropertyTextAlign:
             return kCSSValueKeyword;
         case kCSSPropertyTextDecoration:
@@ -2163,6 +2178,13 @@ const KeywordVector& css_property_keywords(CSSProperty property)
             };
             return keywords;
         }
+        case kCSSPropertyTableLayout: {
+            static const KeywordVector keywords = {
+                { "auto", kTableLayoutAuto },
+                { "fixed", kTableLayoutFixed },
+            };
+            return keywords;
+        }
         case kCSSPropertyTextAlign: {
             static const KeywordVector keywords = {
                 { "left", kTextAlignLeft },
@@ -255,6 +255,14 @@ void CSSSelector::calc_specificity()
     }
 }
 
+bool CSSSelector::is_media_valid(const Document* doc) const
+{
+    if (!media_query_list_) {
+        return true;
+    }
+    return doc && doc->is_media_valid(media_query_list_.get());
+}
+
 void CSSSelector::add_media_to_doc(Document* doc) const
 {
     if (media_query_list_ && doc) {
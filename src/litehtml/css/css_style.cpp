@@ -46,6 +46,13 @@ CSSStyle::CSSStyle()
 {
 }
 
+CSSStyle::CSSStyle(const CSSStyle& style)
+{
+    for (auto& property : style.properties_) {
+        properties_[property.first].reset(property.second->clone());
+    }
+}
+
 CSSStyle::~CSSStyle()
 {
 }
@@ -43,10 +43,20 @@ namespace litehtml {
 void CSSStylesheet::parse(const std::string& str,
     const URL&,
     const Document*,
-    const MediaQueryList::ptr&)
+    const MediaQueryList::ptr& media)
 {
+    size_t first = selectors_.size();
+
     CSSParser parser(str);
     parser.parse_stylesheet(this);
+
+    // The rules only apply when the media query list matches. Keep the list
+    // a selector already has if there is none for the whole stylesheet.
+    if (media) {
+        for (size_t i = first; i < selectors_.size(); i++) {
+            selectors_[i]->media_query_list_ = media;
+        }
+    }
 }
 
 void CSSStylesheet::parse_css_url(const std::string& str, std::string& url)
@@ -677,6 +677,7 @@ CSSToken* CSSTokenizer::next()
         case 'w':
         case 'x':
         case 'y':
+        case 'z':
         case '_':
             return consume_ident(c);
 
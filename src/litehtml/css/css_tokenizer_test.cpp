@@ -140,6 +140,20 @@ TEST(CSSTokenizerTest, NumberSign)
     test(testcases);
 }
 
+TEST(CSSTokenizerTest, Ident)
+{
+    std::vector<CSSTokenizerTestCase> testcases = {
+        {"", {}},
+        {"a", {TS(Ident, "a")}},
+        {"Z", {TS(Ident, "Z")}},
+        {"z-index", {TS(Ident, "z-index")}},
+        {"_x", {TS(Ident, "_x")}},
+        {"-webkit-box", {TS(Ident, "-webkit-box")}},
+    };
+
+    test(testcases);
+}
+
 TEST(CSSTokenizerTest, String)
 {
     std::vector<CSSTokenizerTestCase> testcases = {
@@ -50,6 +50,24 @@ CSSValue::CSSValue(CSSValueType type, const std::string& value, bool important)
     inherit_ = !t_strcasecmp(value.c_str(), "inherit");
 }
 
+CSSValue* CSSValue::clone() const
+{
+    switch (type_) {
+        case kCSSValueColor:
+            return new CSSColorValue(*static_cast<const CSSColorValue*>(this));
+
+        case kCSSValueKeyword:
+            return new CSSKeywordValue(*static_cast<const CSSKeywordValue*>(this));
+
+        case kCSSValueLength:
+            return new CSSLengthValue(*static_cast<const CSSLengthValue*>(this));
+
+        case kCSSValueString:
+        default:
+            return new CSSValue(*this);
+    }
+}
+
 CSSValue* CSSValue::factory(CSSProperty property, const std::string& str, bool important)
 {
     CSSValueType type = css_property_value_type(property);
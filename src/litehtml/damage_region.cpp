@@ -0,0 +1,142 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/damage_region.h"
+
+namespace litehtml {
+
+namespace {
+
+long long rect_area(const Position& rect)
+{
+    return (long long)rect.width * rect.height;
+}
+
+Position united(const Position& a, const Position& b)
+{
+    Position result = a;
+    result.unite(b);
+    return result;
+}
+
+// Whether a and b have a pixel in common.
+bool overlap(const Position& a, const Position& b)
+{
+    return a.left() < b.right() && b.left() < a.right() &&
+           a.top() < b.bottom() && b.top() < a.bottom();
+}
+
+// Whether a and b can be replaced by their union: they overlap, or they are
+// next to each other and their union is no larger than the two.
+bool mergeable(const Position& a, const Position& b)
+{
+    if (overlap(a, b)) {
+        return true;
+    }
+    if (a.left() > b.right() || b.left() > a.right() || a.top() > b.bottom() ||
+        b.top() > a.bottom()) {
+        return false;
+    }
+    return rect_area(united(a, b)) == rect_area(a) + rect_area(b);
+}
+
+} // namespace
+
+void DamageRegion::add(const Position& rect)
+{
+    if (rect.width <= 0 || rect.height <= 0) {
+        return;
+    }
+
+    insert(rect);
+
+    while (rects_.size() > kMaxRects) {
+        size_t best_i = 0;
+        size_t best_j = 1;
+        long long best_waste = -1;
+        for (size_t i = 0; i < rects_.size(); i++) {
+            for (size_t j = i + 1; j < rects_.size(); j++) {
+                long long waste = rect_area(united(rects_[i], rects_[j])) -
+                                  rect_area(rects_[i]) - rect_area(rects_[j]);
+                if (best_waste < 0 || waste < best_waste) {
+                    best_i = i;
+                    best_j = j;
+                    best_waste = waste;
+                }
+            }
+        }
+
+        Position merged = united(rects_[best_i], rects_[best_j]);
+        rects_.erase(rects_.begin() + best_j);
+        rects_.erase(rects_.begin() + best_i);
+        insert(merged);
+    }
+}
+
+// Adds rect, merged with every rectangle it can be merged with (see
+// mergeable()), and with the ones the merged rectangle then overlaps.
+void DamageRegion::insert(Position rect)
+{
+    size_t i = 0;
+    while (i < rects_.size()) {
+        if (mergeable(rect, rects_[i])) {
+            rect.unite(rects_[i]);
+            rects_.erase(rects_.begin() + i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    rects_.push_back(rect);
+}
+
+Position DamageRegion::bounds() const
+{
+    Position result;
+    for (size_t i = 0; i < rects_.size(); i++) {
+        if (i == 0) {
+            result = rects_[i];
+        } else {
+            result.unite(rects_[i]);
+        }
+    }
+    return result;
+}
+
+long long DamageRegion::area() const
+{
+    long long result = 0;
+    for (const Position& rect : rects_) {
+        result += rect_area(rect);
+    }
+    return result;
+}
+
+} // namespace litehtml
@@ -0,0 +1,122 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/damage_region.h"
+
+#include <gtest/gtest.h>
+
+using namespace litehtml;
+
+namespace {
+
+bool overlap(const Position& a, const Position& b)
+{
+  return a.left() < b.right() && b.left() < a.right() &&
+         a.top() < b.bottom() && b.top() < a.bottom();
+}
+
+} // namespace
+
+TEST(DamageRegionTest, Empty)
+{
+  DamageRegion region;
+  region.add(Position(10, 10, 0, 20));
+  region.add(Position(10, 10, 20, -1));
+  EXPECT_TRUE(region.empty());
+  EXPECT_EQ(0, region.area());
+}
+
+TEST(DamageRegionTest, Overlapping)
+{
+  DamageRegion region;
+  region.add(Position(0, 0, 100, 100));
+  region.add(Position(50, 50, 100, 100));
+  ASSERT_EQ(1u, region.rects().size());
+  EXPECT_EQ(0, region.rects()[0].x);
+  EXPECT_EQ(0, region.rects()[0].y);
+  EXPECT_EQ(150, region.rects()[0].width);
+  EXPECT_EQ(150, region.rects()[0].height);
+
+  // Contained rectangles add nothing.
+  region.add(Position(10, 10, 20, 20));
+  ASSERT_EQ(1u, region.rects().size());
+  EXPECT_EQ(150 * 150, region.area());
+}
+
+TEST(DamageRegionTest, Adjacent)
+{
+  DamageRegion region;
+  region.add(Position(0, 0, 100, 20));
+  region.add(Position(0, 20, 100, 20));
+  ASSERT_EQ(1u, region.rects().size());
+  EXPECT_EQ(40, region.rects()[0].height);
+
+  // Next to it, but their union would be larger than the two.
+  region.add(Position(100, 0, 50, 10));
+  EXPECT_EQ(2u, region.rects().size());
+  EXPECT_EQ(100 * 40 + 50 * 10, region.area());
+
+  // Apart from both.
+  region.add(Position(0, 100, 10, 10));
+  EXPECT_EQ(3u, region.rects().size());
+
+  Position bounds = region.bounds();
+  EXPECT_EQ(0, bounds.x);
+  EXPECT_EQ(0, bounds.y);
+  EXPECT_EQ(150, bounds.width);
+  EXPECT_EQ(110, bounds.height);
+}
+
+TEST(DamageRegionTest, MaxRects)
+{
+  DamageRegion region;
+  for (int i = 0; i < 40; i++) {
+    region.add(Position((i % 5) * 100, (i / 5) * 100, 10 + i, 10));
+  }
+
+  EXPECT_LE(region.rects().size(), DamageRegion::kMaxRects);
+  const std::vector<Position>& rects = region.rects();
+  for (size_t i = 0; i < rects.size(); i++) {
+    for (size_t j = i + 1; j < rects.size(); j++) {
+      EXPECT_FALSE(overlap(rects[i], rects[j]));
+    }
+  }
+
+  // Every rectangle added is still covered.
+  for (int i = 0; i < 40; i++) {
+    Position rect((i % 5) * 100, (i / 5) * 100, 10 + i, 10);
+    bool covered = false;
+    for (const Position& r : rects) {
+      covered |= r.left() <= rect.left() && r.right() >= rect.right() &&
+                 r.top() <= rect.top() && r.bottom() >= rect.bottom();
+    }
+    EXPECT_TRUE(covered) << i;
+  }
+}
@@ -0,0 +1,288 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/display_list.h"
+
+#include "litehtml/document.h"
+#include "litehtml/document_container.h"
+
+namespace litehtml {
+
+// Records the draw calls into a display list, and passes the other calls on
+// to the document's container.
+class DisplayList::Recorder : public DocumentContainer {
+    DisplayList& list_;
+    DocumentContainer* container_;
+
+    void add(ItemType type, int index, const Position& bounds)
+    {
+        list_.items_.push_back(Item{type, index, bounds});
+    }
+
+public:
+    Recorder(DisplayList& list, DocumentContainer* container)
+    : list_(list)
+    , container_(container)
+    {
+    }
+
+    virtual void draw_text(uintptr_t,
+        const char* text,
+        uintptr_t hFont,
+        Color color,
+        const Position& pos) override
+    {
+        add(kItemText, (int)list_.texts_.size(), pos);
+        list_.texts_.push_back(TextCall{text, hFont, color, pos});
+    }
+
+    virtual void draw_background(uintptr_t, const BackgroundPaint& bg) override
+    {
+        add(kItemBackground, (int)list_.backgrounds_.size(), bg.clip_box);
+        list_.backgrounds_.push_back(bg);
+    }
+
+    virtual void draw_borders(uintptr_t,
+        const Borders& borders,
+        const Position& draw_pos,
+        bool root) override
+    {
+        add(kItemBorders, (int)list_.borders_.size(), draw_pos);
+        list_.borders_.push_back(BordersCall{borders, draw_pos, root});
+    }
+
+    virtual void draw_list_marker(uintptr_t, const list_marker& marker) override
+    {
+        add(kItemListMarker, (int)list_.markers_.size(), marker.pos);
+        list_.markers_.push_back(marker);
+    }
+
+    virtual void set_clip(const Position& pos,
+        const BorderRadii& border_radii,
+        bool valid_x,
+        bool valid_y) override
+    {
+        add(kItemSetClip, (int)list_.clips_.size(), pos);
+        list_.clips_.push_back(ClipCall{pos, border_radii, valid_x, valid_y});
+    }
+
+    virtual void del_clip() override
+    {
+        add(kItemDelClip, 0, Position());
+    }
+
+    virtual uintptr_t create_font(const char* faceName,
+        int size,
+        int weight,
+        font_style italic,
+        unsigned int decoration,
+        FontMetrics* fm) override
+    {
+        return container_->create_font(faceName, size, weight, italic, decoration, fm);
+    }
+
+    virtual void delete_font(uintptr_t hFont) override
+    {
+        container_->delete_font(hFont);
+    }
+
+    virtual int text_width(const char* text, uintptr_t hFont) override
+    {
+        return container_->text_width(text, hFont);
+    }
+
+    virtual void measure_texts(const TextRun* runs, size_t count, int* widths) override
+    {
+        container_->measure_texts(runs, count, widths);
+    }
+
+    virtual int pt_to_px(int pt) override
+    {
+        return container_->pt_to_px(pt);
+    }
+
+    virtual int get_default_font_size() const override
+    {
+        return container_->get_default_font_size();
+    }
+
+    virtual const char* get_default_font_name() const override
+    {
+        return container_->get_default_font_name();
+    }
+
+    virtual void load_image(const URL& url, bool redraw_on_ready) override
+    {
+        container_->load_image(url, redraw_on_ready);
+    }
+
+    virtual Size get_image_size(const URL& url) override
+    {
+        return container_->get_image_size(url);
+    }
+
+    virtual void set_caption(const char* caption) override
+    {
+        container_->set_caption(caption);
+    }
+
+    virtual void link(const Document* doc, const Element::ptr& el) override
+    {
+        container_->link(doc, el);
+    }
+
+    virtual void on_anchor_click(const char* url, const Element* el) override
+    {
+        container_->on_anchor_click(url, el);
+    }
+
+    virtual void set_cursor(const char* cursor) override
+    {
+        container_->set_cursor(cursor);
+    }
+
+    virtual void transform_text(std::string& text, TextTransform tt) override
+    {
+        container_->transform_text(text, tt);
+    }
+
+    virtual std::string import_css(const URL& css_url) override
+    {
+        return container_->import_css(css_url);
+    }
+
+    virtual std::string import_js(const URL& js_url) override
+    {
+        return container_->import_js(js_url);
+    }
+
+    virtual Position get_client_rect() const override
+    {
+        return container_->get_client_rect();
+    }
+
+    virtual void get_media_features(MediaFeatures& media) const override
+    {
+        container_->get_media_features(media);
+    }
+
+    virtual void get_language(std::string& language,
+        std::string& culture) const override
+    {
+        container_->get_language(language, culture);
+    }
+};
+
+void DisplayList::record(Document* document, int x, int y)
+{
+    clear();
+    x_ = x;
+    y_ = y;
+
+    DocumentContainer* container = document->container_;
+    Recorder recorder(*this, container);
+    document->container_ = &recorder;
+    document->draw((uintptr_t)0, x, y, nullptr);
+    document->container_ = container;
+}
+
+void DisplayList::replay(DocumentContainer* container,
+    uintptr_t hdc,
+    const Position* clip) const
+{
+    for (const Item& item : items_) {
+        // Clips are always set (and removed), so they stay balanced.
+        if (item.type != kItemSetClip && item.type != kItemDelClip &&
+            !item.bounds.does_intersect(clip)) {
+            continue;
+        }
+
+        switch (item.type) {
+            case kItemText: {
+                const TextCall& call = texts_[item.index];
+                container->draw_text(hdc,
+                    call.text.c_str(),
+                    call.font,
+                    call.color,
+                    call.pos);
+                break;
+            }
+            case kItemBackground:
+                container->draw_background(hdc, backgrounds_[item.index]);
+                break;
+            case kItemBorders: {
+                const BordersCall& call = borders_[item.index];
+                container->draw_borders(hdc, call.borders, call.draw_pos, call.root);
+                break;
+            }
+            case kItemListMarker:
+                container->draw_list_marker(hdc, markers_[item.index]);
+                break;
+            case kItemSetClip: {
+                const ClipCall& call = clips_[item.index];
+                container->set_clip(call.pos,
+                    call.border_radii,
+                    call.valid_x,
+                    call.valid_y);
+                break;
+            }
+            case kItemDelClip:
+                container->del_clip();
+                break;
+        }
+    }
+}
+
+void DisplayList::replay(DocumentContainer* container,
+    uintptr_t hdc,
+    const DamageRegion& region) const
+{
+    for (const Position& rect : region.rects()) {
+        Position clip = rect;
+        clip.x += x_;
+        clip.y += y_;
+
+        container->set_clip(clip, BorderRadii(), true, true);
+        replay(container, hdc, &clip);
+        container->del_clip();
+    }
+}
+
+void DisplayList::clear()
+{
+    items_.clear();
+    texts_.clear();
+    backgrounds_.clear();
+    borders_.clear();
+    markers_.clear();
+    clips_.clear();
+}
+
+} // namespace litehtml
@@ -0,0 +1,225 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/display_list.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "litehtml/context.h"
+#include "litehtml/document.h"
+#include "litehtml/document_parser.h"
+#include "test_container.h"
+
+using namespace litehtml;
+
+namespace {
+
+// A container that logs the draw calls made on it.
+class logging_container : public test_container {
+public:
+    std::vector<std::string> calls;
+
+    static std::string str(const Position& pos)
+    {
+        return std::to_string(pos.x) + "," + std::to_string(pos.y) + "," +
+               std::to_string(pos.width) + "," + std::to_string(pos.height);
+    }
+
+    virtual void draw_text(uintptr_t hdc,
+        const char* text,
+        uintptr_t,
+        Color,
+        const Position& pos) override
+    {
+        calls.push_back(std::to_string(hdc) + " text " + text + " " + str(pos));
+    }
+
+    virtual void draw_background(uintptr_t hdc,
+        const BackgroundPaint& bg) override
+    {
+        calls.push_back(std::to_string(hdc) + " background " + str(bg.clip_box));
+    }
+
+    virtual void draw_borders(uintptr_t hdc,
+        const Borders&,
+        const Position& draw_pos,
+        bool) override
+    {
+        calls.push_back(std::to_string(hdc) + " borders " + str(draw_pos));
+    }
+
+    virtual void draw_list_marker(uintptr_t hdc,
+        const list_marker& marker) override
+    {
+        calls.push_back(std::to_string(hdc) + " marker " + str(marker.pos));
+    }
+
+    virtual void set_clip(const Position& pos,
+        const BorderRadii&,
+        bool,
+        bool) override
+    {
+        calls.push_back("set_clip " + str(pos));
+    }
+
+    virtual void del_clip() override
+    {
+        calls.push_back("del_clip");
+    }
+};
+
+const char* kHtml =
+    "<html><head><style>"
+    "body, div, p { display: block }"
+    "ul { display: block; list-style-type: disc }"
+    "li { display: list-item }"
+    "div { background-color: red; border: 1px solid black; height: 50px }"
+    "#clip { overflow: hidden; height: 20px }"
+    "#pos { position: absolute; top: 300px; left: 10px; width: 40px }"
+    "</style></head><body>"
+    "<div>one</div>"
+    "<div id=\"clip\"><p>two three</p></div>"
+    "<ul><li>four</li></ul>"
+    "<div id=\"pos\">five</div>"
+    "</body></html>";
+
+} // namespace
+
+TEST(DisplayListTest, Replay)
+{
+    Context context;
+    logging_container container;
+    Document* document = DocumentParser::parse(kHtml, URL(), &container, &context);
+    document->render(500);
+
+    document->draw((uintptr_t)1, 10, 20, nullptr);
+    std::vector<std::string> expected = container.calls;
+    EXPECT_FALSE(expected.empty());
+    container.calls.clear();
+
+    DisplayList list;
+    list.record(document, 10, 20);
+    EXPECT_EQ(expected.size(), list.size());
+
+    // Recording doesn't draw anything.
+    EXPECT_TRUE(container.calls.empty());
+
+    list.replay(&container, (uintptr_t)1, nullptr);
+    EXPECT_EQ(expected, container.calls);
+
+    // Replaying again makes the same calls.
+    container.calls.clear();
+    list.replay(&container, (uintptr_t)1, nullptr);
+    EXPECT_EQ(expected, container.calls);
+
+    delete document;
+}
+
+TEST(DisplayListTest, Clip)
+{
+    Context context;
+    logging_container container;
+    Document* document = DocumentParser::parse(kHtml, URL(), &container, &context);
+    document->render(500);
+
+    DisplayList list;
+    list.record(document, 0, 0);
+
+    // Only the calls that draw in the clip rectangle are made, along with all
+    // of the clips.
+    Position clip(0, 250, 500, 100);
+    list.replay(&container, (uintptr_t)0, &clip);
+
+    int set_clips = 0;
+    int del_clips = 0;
+    bool positioned = false;
+    for (const std::string& call : container.calls) {
+        if (call.compare(0, 8, "set_clip") == 0) {
+            set_clips++;
+        } else if (call == "del_clip") {
+            del_clips++;
+        } else if (call == "0 background 10,300,42,52") {
+            positioned = true;
+        } else {
+            EXPECT_EQ(std::string::npos, call.find("0,0,")) << call;
+        }
+    }
+    EXPECT_GT(set_clips, 0);
+    EXPECT_EQ(set_clips, del_clips);
+    EXPECT_TRUE(positioned);
+    EXPECT_LT(container.calls.size(), list.size());
+
+    delete document;
+}
+
+TEST(DisplayListTest, DamageRegion)
+{
+    Context context;
+    logging_container container;
+    Document* document = DocumentParser::parse(kHtml, URL(), &container, &context);
+    document->render(500);
+
+    DamageRegion region;
+    region.add(Position(0, 0, 500, 10));
+    region.add(Position(0, 300, 100, 60));
+
+    DisplayList list;
+    list.record(document, 10, 20);
+    list.replay(&container, (uintptr_t)1, region);
+
+    // Each rectangle is drawn clipped to itself, and only the calls that
+    // draw in it are made.
+    std::vector<std::string> texts;
+    int set_clips = 0;
+    int del_clips = 0;
+    for (const std::string& call : container.calls) {
+        if (call.compare(0, 8, "set_clip") == 0) {
+            set_clips++;
+        } else if (call == "del_clip") {
+            del_clips++;
+        } else if (call.compare(0, 7, "1 text ") == 0) {
+            texts.push_back(call);
+        }
+    }
+    EXPECT_EQ("set_clip 10,20,500,10", container.calls.front());
+    EXPECT_EQ("del_clip", container.calls.back());
+    EXPECT_EQ(set_clips, del_clips);
+
+    std::vector<std::string> expected = {
+        "1 text one 11,21,0,15",
+        "1 text five 21,321,0,15",
+    };
+    EXPECT_EQ(expected, texts);
+
+    delete document;
+}
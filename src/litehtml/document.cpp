@@ -32,11 +32,12 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <algorithm>
+#include <map>
 
 #include <gumbo.h>
-#include <utf8cpp/utf8.h>
 
 
 #include "litehtml/css/css_stylesheet.h"
@@ -67,12 +68,13 @@
 #include "litehtml/utf8_strings.h"
 #include "litehtml/logging.h"
 #include "litehtml/text.h"
-#include "litehtml/string_view.h"
+#include "litehtml/thread_pool.h"
 
 #if defined(USE_ICU)
 
 #include "unicode/brkiter.h"
 #include "unicode/udata.h"
+#include "unicode/utext.h"
 
 using namespace icu;
 
@@ -86,79 +88,133 @@ namespace {
 // approach simplifies the renderer as the parser computes and caches the text
 // extents while the renderer only has to draw each individual element.
 
+// Split text into alternating runs of whitespace and non-whitespace. Gumbo
+// always produces valid UTF-8, and whitespace characters are always ASCII,
+// so the text does not need to be decoded (see find_whitespace()).
+void split_text_node_whitespace(Document* document,
+    ElementsVector& elements,
+    const char* text,
+    const char* end)
+{
+    const char* p = text;
+    while (p != end) {
+        const char* run_end = find_whitespace(p, end);
+        if (run_end != p) {
+            elements.push_back(new TextElement(document, p, run_end - p));
+            p = run_end;
+        }
+
+        run_end = find_non_whitespace(p, end);
+        if (run_end != p) {
+            elements.push_back(new WhitespaceElement(document, p, run_end - p));
+            p = run_end;
+        }
+    }
+}
+
 #if defined(USE_ICU)
 
-void split_text_node(Document* document, ElementsVector& elements, const char* text)
+// Returns true if ICU only finds line break opportunities in [begin, end)
+// after runs of spaces, as split_text_node_spaces() does. That holds for
+// text made of letters, digits, spaces and the punctuation below, whatever
+// the locale; other punctuation (e.g., the hyphen in "well-known") and other
+// whitespace (e.g., newlines) have break rules of their own.
+bool has_simple_line_breaks(const char* begin, const char* end)
 {
-    UErrorCode code = U_ZERO_ERROR;
-    BreakIterator* break_iterator =
-        BreakIterator::createLineInstance(Locale::getEnglish(), code);
-
-    break_iterator->setText(text);
+    static const char kPunctuation[] = ".,:;)]\"#&*<=>@^_`~'";
 
-    int32_t start = break_iterator->first();
-    for (int32_t end = break_iterator->next(); end != BreakIterator::DONE;
-         start = end, end = break_iterator->next()) {
-        std::string str(text + start, end - start);
-        elements.push_back(new TextElement(document, str.c_str()));
+    for (const char* p = begin; p != end; p++) {
+        char c = *p;
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+            (c >= '0' && c <= '9') || c == ' ') {
+            continue;
+        }
+        if (c == '\0' || !memchr(kPunctuation, c, sizeof(kPunctuation) - 1)) {
+            return false;
+        }
     }
+    return true;
 }
 
-#else
+// Splits text for which has_simple_line_breaks() is true into the same text
+// elements as the ICU line break iterator: each word with the spaces after
+// it. ICU doesn't break before some punctuation even after spaces (".",
+// ",", ":" and ";", unless they start a number like ".5", and ")" and "]"),
+// so neither does this.
+void split_text_node_spaces(Document* document,
+    ElementsVector& elements,
+    const char* text,
+    const char* end)
+{
+    const char* start = text;
+    for (const char* p = text; p != end;) {
+        if (*p++ != ' ' || (p != end && *p == ' ')) {
+            continue;
+        }
+        if (p != end) {
+            char c = *p;
+            bool number = p + 1 != end && p[1] >= '0' && p[1] <= '9';
+            if (c == ')' || c == ']' ||
+                ((c == '.' || c == ',' || c == ':' || c == ';') && !number)) {
+                continue;
+            }
+        }
+        elements.push_back(new TextElement(document, start, p - start));
+        start = p;
+    }
+    if (start != end) {
+        elements.push_back(new TextElement(document, start, end - start));
+    }
+}
 
 void split_text_node(Document* document, ElementsVector& elements, const char* text)
 {
-    const char* end = text + strlen(text);
-
-    StringView str;
-    StringView wss;
+    size_t length = strlen(text);
 
-    utf8::iterator<const char*> iterator(text, text, text + strlen(text));
-
-    const char* p = text;
-    while (p != end) {
-        const char* prev = p;
-        char32_t c = utf8::next(p, end);
+    // Most text breaks only after spaces, which doesn't need ICU.
+    if (has_simple_line_breaks(text, text + length)) {
+        split_text_node_spaces(document, elements, text, text + length);
+        return;
+    }
 
-        if (is_whitespace(c)) {
-            if (!str.empty()) {
-                elements.push_back(new TextElement(document, str.data(), str.length()));
-                str = StringView();
-            }
-            if (wss.empty()) {
-                wss = StringView(prev, (p - prev));
-            } else {
-                wss = StringView(wss.data(), (p - wss.data()));
-            }
-        } else {
-            if (!wss.empty()) {
-                elements.push_back(new WhitespaceElement(document, wss.data(), wss.length()));
-                wss = StringView();
-            }
-            if (str.empty()) {
-                str = StringView(prev, (p - prev));
-            } else {
-                str = StringView(str.data(), (p - str.data()));
-            }
-        }
+    BreakIterator* break_iterator = document->line_break_iterator();
+    if (!break_iterator) {
+        split_text_node_whitespace(document, elements, text, text + length);
+        return;
     }
 
-    if (!str.empty()) {
-        elements.push_back(new TextElement(document, str.data(), str.length()));
-        str = StringView();
+    // Iterate over the UTF-8 text directly so the break iterator returns
+    // byte offsets rather than UTF-16 offsets.
+    UErrorCode code = U_ZERO_ERROR;
+    UText* utext = utext_openUTF8(nullptr, text, length, &code);
+    break_iterator->setText(utext, code);
+    if (U_FAILURE(code)) {
+        utext_close(utext);
+        split_text_node_whitespace(document, elements, text, text + length);
+        return;
     }
 
-    if (!wss.empty()) {
-        elements.push_back(new WhitespaceElement(document, wss.data(), wss.length()));
-        wss = StringView();
+    int32_t start = break_iterator->first();
+    for (int32_t end = break_iterator->next(); end != BreakIterator::DONE;
+         start = end, end = break_iterator->next()) {
+        elements.push_back(new TextElement(document, text + start, end - start));
     }
+
+    utext_close(utext);
+}
+
+#else
+
+void split_text_node(Document* document, ElementsVector& elements, const char* text)
+{
+    split_text_node_whitespace(document, elements, text, text + strlen(text));
 }
 
 #endif
 
 } // namespace
 
-Document::Document(DocumentContainer* container, Context* context)
+Document::Document(DocumentContainer* container, const Context* context)
 : container_(container)
 , context_(context)
 {
@@ -166,13 +222,59 @@ Document::Document(DocumentContainer* container, Context* context)
 
 Document::Document(const URL& base_url,
     DocumentContainer* container,
-    Context* context)
+    const Context* context)
 : container_(container)
 , context_(context)
 , base_url_(base_url)
 {
 }
 
+#if defined(USE_ICU)
+
+// Line break iterators are expensive to create, so the document creates one
+// iterator per locale and reuses it for every text node.
+class BreakIteratorCache {
+    std::unordered_map<std::string, std::unique_ptr<BreakIterator>> iterators_;
+
+public:
+    BreakIterator* get(const std::string& locale)
+    {
+        auto iterator = iterators_.find(locale);
+        if (iterator != iterators_.end()) {
+            return iterator->second.get();
+        }
+
+        UErrorCode code = U_ZERO_ERROR;
+        std::unique_ptr<BreakIterator> break_iterator(
+            BreakIterator::createLineInstance(Locale::createFromName(locale.c_str()), code));
+        if (U_FAILURE(code)) {
+            break_iterator.reset();
+        }
+
+        BreakIterator* result = break_iterator.get();
+        iterators_[locale] = std::move(break_iterator);
+        return result;
+    }
+};
+
+BreakIterator* Document::line_break_iterator()
+{
+    if (!break_iterators_) {
+        break_iterators_.reset(new BreakIteratorCache());
+    }
+
+    // ICU locale names use underscores (e.g., "en_US") rather than hyphens.
+    std::string locale = culture_.empty() ? language_ : culture_;
+    std::replace(locale.begin(), locale.end(), '-', '_');
+    if (locale.empty()) {
+        locale = "en";
+    }
+
+    return break_iterators_->get(locale);
+}
+
+#endif
+
 Document::~Document()
 {
     m_over_element = nullptr;
@@ -183,6 +285,124 @@ Document::~Document()
     }
 }
 
+Document* Document::clone() const
+{
+    Document* document = new Document(base_url_, container_, context_);
+
+    document->m_css = m_css;
+    document->m_scripts = m_scripts;
+    document->stylesheet_ = stylesheet_;
+    document->default_color_ = default_color_;
+    document->m_media_lists = m_media_lists;
+    document->media_list_results_ = media_list_results_;
+    document->m_media = m_media;
+    document->language_ = language_;
+    document->culture_ = culture_;
+    document->has_viewport_ = has_viewport_;
+    document->viewport_ = viewport_;
+
+    if (root_) {
+        document->root_.reset(root_->clone(document));
+
+        // Font handles belong to the document that created them, so resolve
+        // the fonts again against the copy.
+        document->init_fonts(document->root_.get());
+
+        // Rebuild the table grids (they hold pointers to the elements).
+        document->root_->init();
+    }
+
+    return document;
+}
+
+std::vector<Document*> Document::render_widths(const std::vector<int>& widths) const
+{
+    std::vector<Document*> documents;
+
+    // The documents styled for each combination of media query results. A
+    // copy of one of them only needs styling if the results differ.
+    std::map<std::vector<bool>, const Document*> styled;
+    std::vector<bool> results;
+    for (const auto& list : m_media_lists) {
+        results.push_back(is_media_valid(list.get()));
+    }
+    styled[results] = this;
+
+    // Each copy is laid out in a viewport of its own width.
+    Position viewport = client_rect();
+
+    for (int width : widths) {
+        MediaFeatures media = m_media;
+        media.width = width;
+        viewport.width = width;
+
+        results.clear();
+        for (const auto& list : m_media_lists) {
+            results.push_back(list->check(media));
+        }
+
+        Document* document;
+        auto it = styled.find(results);
+        if (it != styled.end()) {
+            document = it->second->clone();
+            document->m_media = media;
+        } else {
+            document = clone();
+            document->m_media = media;
+            document->update_media_lists(media);
+            if (document->root_) {
+                document->root_->refresh_styles();
+                document->parse_styles(document->root_.get());
+            }
+            styled[results] = document;
+        }
+
+        document->has_viewport_ = true;
+        document->viewport_ = viewport;
+        document->render(width);
+        documents.push_back(document);
+    }
+
+    return documents;
+}
+
+Position Document::client_rect() const
+{
+    return has_viewport_ ? viewport_ : container_->get_client_rect();
+}
+
+void Document::parse_styles(Element* element)
+{
+    if (text_batch_) {
+        element->parse_styles();
+        return;
+    }
+
+    std::vector<TextElement*> batch;
+    text_batch_ = &batch;
+    element->parse_styles();
+    text_batch_ = nullptr;
+
+    TextElement::measure(this, batch);
+}
+
+bool Document::measure_text_later(TextElement* element)
+{
+    if (!text_batch_) {
+        return false;
+    }
+    text_batch_->push_back(element);
+    return true;
+}
+
+void Document::init_fonts(Element* element)
+{
+    element->init_font();
+    for (auto child : element->m_children) {
+        init_fonts(child);
+    }
+}
+
 uintptr_t Document::add_font(const char* name,
     int size,
     const char* weight,
@@ -312,6 +532,22 @@ int Document::render(int max_width)
 {
     int ret = 0;
     if (root_) {
+        // The layout also depends on the size of the client rectangle (e.g.,
+        // percentage heights and fixed positioned elements).
+        Position client_rect = this->client_rect();
+        if (client_rect.width != render_client_rect_.width ||
+            client_rect.height != render_client_rect_.height) {
+            render_client_rect_ = client_rect;
+            invalidate_layout();
+        }
+
+        if (!root_->needs_layout() && max_width == render_width_) {
+            return render_result_;
+        }
+
+        render_tree_valid_ = false;
+        layout_count_++;
+
         ret = root_->render(0, 0, max_width);
         if (root_->fetch_positioned()) {
             root_->render_positioned();
@@ -319,18 +555,203 @@ int Document::render(int max_width)
         m_size.width = 0;
         m_size.height = 0;
         root_->calc_document_size(m_size);
+
+        render_width_ = max_width;
+        render_result_ = ret;
+
+        if (track_damage_) {
+            update_damage();
+        }
     }
     return ret;
 }
 
+void Document::set_track_damage(bool track)
+{
+    track_damage_ = track;
+    damage_.clear();
+    damage_boxes_.clear();
+    changed_elements_.clear();
+
+    // Start from the current layout, if there is one.
+    if (track && root_ && render_width_ >= 0 && !root_->needs_layout()) {
+        add_damage_boxes(root_.get(), 0, 0, damage_boxes_);
+    }
+}
+
+// Adds the area element and its descendants draw in to boxes, in document
+// coordinates. (x, y) is the content box of the parent.
+void Document::add_damage_boxes(Element* element,
+    int x,
+    int y,
+    std::vector<std::pair<const Element*, Position>>& boxes)
+{
+    if (element->skip() || element->get_display() == kDisplayNone) {
+        return;
+    }
+
+    if (element->get_element_position() == kPositionFixed) {
+        x = render_client_rect_.x;
+        y = render_client_rect_.y;
+    }
+
+    if (element->is_visible()) {
+        Position box;
+        if (!element->get_draw_bounds(box)) {
+            // The element (e.g., a list item with a marker) may draw to
+            // either side of its border box, but not above or below it.
+            box = element->get_position();
+            box += element->padding();
+            box += element->border();
+            box.x = -x;
+            box.width = std::max(m_size.width, render_width_);
+        }
+        box.x += x;
+        box.y += y;
+        boxes.emplace_back(element, box);
+    }
+
+    const Position& content = element->get_position();
+    for (size_t i = 0; i < element->get_children_count(); i++) {
+        add_damage_boxes(element->get_child((int)i),
+            x + content.x,
+            y + content.y,
+            boxes);
+    }
+}
+
+// Adds to the damage where the elements that changed or moved since the last
+// render were and are drawn.
+void Document::update_damage()
+{
+    std::vector<std::pair<const Element*, Position>> boxes;
+    boxes.reserve(damage_boxes_.size());
+    add_damage_boxes(root_.get(), 0, 0, boxes);
+
+    auto changed = [this](const Element* element,
+                       const Position& old_box,
+                       const Position& box) {
+        return old_box.x != box.x || old_box.y != box.y ||
+               old_box.width != box.width || old_box.height != box.height ||
+               changed_elements_.count(element);
+    };
+
+    // Most changes leave the same elements visible, so the boxes can be
+    // compared in order.
+    size_t same = 0;
+    while (same < boxes.size() && same < damage_boxes_.size() &&
+           boxes[same].first == damage_boxes_[same].first) {
+        const Position& old_box = damage_boxes_[same].second;
+        const Position& box = boxes[same].second;
+        if (changed(boxes[same].first, old_box, box)) {
+            damage_.add(old_box);
+            damage_.add(box);
+        }
+        same++;
+    }
+
+    if (same < boxes.size() || same < damage_boxes_.size()) {
+        std::unordered_map<const Element*, Position> old_boxes(
+            damage_boxes_.begin() + same,
+            damage_boxes_.end());
+        for (size_t i = same; i < boxes.size(); i++) {
+            const Position& box = boxes[i].second;
+            auto old = old_boxes.find(boxes[i].first);
+            if (old == old_boxes.end()) {
+                damage_.add(box);
+                continue;
+            }
+            if (changed(boxes[i].first, old->second, box)) {
+                damage_.add(old->second);
+                damage_.add(box);
+            }
+            old_boxes.erase(old);
+        }
+
+        // The elements that were removed or hidden.
+        for (auto& item : old_boxes) {
+            damage_.add(item.second);
+        }
+    }
+
+    damage_boxes_.swap(boxes);
+    changed_elements_.clear();
+}
+
+const RenderTree& Document::render_tree()
+{
+    if (!render_tree_valid_) {
+        render_tree_.build(root_.get());
+        render_tree_valid_ = true;
+    }
+    return render_tree_;
+}
+
+void Document::invalidate_layout()
+{
+    layout_generation_++;
+    if (root_) {
+        root_->invalidate_layout();
+    }
+}
+
+void Document::set_layout_threads(int count)
+{
+    if (count > 1) {
+        layout_pool_.reset(new ThreadPool(count));
+    } else {
+        layout_pool_.reset();
+    }
+}
+
+int Document::layout_threads() const
+{
+    return layout_pool_ ? layout_pool_->threads() : 1;
+}
+
+void Document::layout_in_parallel(size_t count,
+    const std::function<void(size_t)>& fn)
+{
+    if (layout_pool_) {
+        layout_pool_->parallel_for(count, fn);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+    }
+}
+
+void Document::discard_stale_paint_orders()
+{
+    // The document changed since it was last rendered; don't draw it (or
+    // look for elements in it) with a paint order found for the old layout.
+    if (root_ && root_->needs_layout()) {
+        layout_count_++;
+    }
+}
+
 void Document::draw(uintptr_t hdc, int x, int y, const Position* clip)
 {
     if (root_) {
+        discard_stale_paint_orders();
         root_->draw(hdc, x, y, clip);
         root_->draw_stacking_context(hdc, x, y, clip, true);
     }
 }
 
+void Document::draw(uintptr_t hdc, int x, int y, const DamageRegion& region)
+{
+    for (const Position& rect : region.rects()) {
+        Position clip = rect;
+        clip.x += x;
+        clip.y += y;
+
+        container_->set_clip(clip, BorderRadii(), true, true);
+        draw(hdc, x, y, &clip);
+        container_->del_clip();
+    }
+}
+
 int Document::cvt_units(const char* str,
     int fontSize,
     bool* is_percent /*= 0*/) const
@@ -437,6 +858,7 @@ bool Document::on_mouse_over(int x,
         return false;
     }
 
+    discard_stale_paint_orders();
     Element::ptr over_el = root_->get_element_by_point(x, y, client_x, client_y);
 
     bool state_was_changed = false;
@@ -490,6 +912,7 @@ bool Document::on_lbutton_down(int x,
         return false;
     }
 
+    discard_stale_paint_orders();
     Element::ptr over_el = root_->get_element_by_point(x, y, client_x, client_y);
 
     bool state_was_changed = false;
@@ -600,27 +1023,36 @@ bool Document::media_changed()
 {
     if (!m_media_lists.empty()) {
         container()->get_media_features(m_media);
+        if (has_viewport_) {
+            m_media.width = viewport_.width;
+            m_media.height = viewport_.height;
+        }
         if (update_media_lists(m_media)) {
             root_->refresh_styles();
-            root_->parse_styles();
+            parse_styles(root_.get());
             return true;
         }
     }
     return false;
 }
 
+void Document::update_language()
+{
+    std::string culture;
+    container()->get_language(language_, culture);
+    if (!culture.empty()) {
+        culture_ = language_ + '-' + culture;
+    } else {
+        culture_.clear();
+    }
+}
+
 bool Document::lang_changed()
 {
     if (!m_media_lists.empty()) {
-        std::string culture;
-        container()->get_language(language_, culture);
-        if (!culture.empty()) {
-            culture_ = language_ + '-' + culture;
-        } else {
-            culture_.clear();
-        }
+        update_language();
         root_->refresh_styles();
-        root_->parse_styles();
+        parse_styles(root_.get());
         return true;
     }
     return false;
@@ -629,16 +1061,26 @@ bool Document::lang_changed()
 bool Document::update_media_lists(const MediaFeatures& features)
 {
     bool update_styles = false;
-    for (MediaQueryList::vector::iterator iter = m_media_lists.begin();
-         iter != m_media_lists.end();
-         iter++) {
-        if ((*iter)->apply_MediaFeatures(features)) {
+    for (const auto& list : m_media_lists) {
+        bool apply = list->check(features);
+        bool& result = media_list_results_[list.get()];
+        if (apply != result) {
+            result = apply;
             update_styles = true;
         }
     }
     return update_styles;
 }
 
+bool Document::is_media_valid(const MediaQueryList* list) const
+{
+    auto result = media_list_results_.find(list);
+    if (result != media_list_results_.end()) {
+        return result->second;
+    }
+    return false;
+}
+
 void Document::add_media_list(MediaQueryList::ptr list)
 {
     if (list) {
@@ -761,53 +1203,44 @@ void Document::fix_tables_layout()
         }
         i++;
     }
+
+    // The elements have been fixed up; don't process them again when more
+    // children are appended to the document.
+    m_tabular_elements.clear();
 }
 
 void Document::fix_table_children(Element::ptr& el_ptr,
     Display disp,
     const char* disp_str)
 {
+    // Rebuild the list of children in a single pass. Wrapping each run of
+    // children in place would shift the rest of the vector once per wrapped
+    // child, which is quadratic for large tables.
+    ElementsVector children;
+    children.reserve(el_ptr->m_children.size());
     ElementsVector tmp;
-    ElementsVector::iterator first_iter = el_ptr->m_children.begin();
-    ElementsVector::iterator cur_iter = el_ptr->m_children.begin();
 
-    auto flush_elements = [&]() {
-        Element::ptr annon_tag = new HTMLElement(this);
-        CSSStyle st;
-        st.add_property(kCSSPropertyDisplay, disp_str, URL(), false);
-        annon_tag->add_style(st);
-        annon_tag->parent(el_ptr);
-        annon_tag->parse_styles();
-        annon_tag->append_children(tmp);
-        first_iter = el_ptr->m_children.insert(first_iter, annon_tag);
-        cur_iter = first_iter + 1;
-        while (cur_iter != el_ptr->m_children.end() &&
-               (*cur_iter)->parent() != el_ptr) {
-            cur_iter = el_ptr->m_children.erase(cur_iter);
-        }
-        first_iter = cur_iter;
-        tmp.clear();
-    };
-
-    while (cur_iter != el_ptr->m_children.end()) {
-        if ((*cur_iter)->get_display() != disp) {
-            if (!(*cur_iter)->is_whitespace() ||
-                ((*cur_iter)->is_whitespace() && !tmp.empty())) {
-                if (tmp.empty()) {
-                    first_iter = cur_iter;
-                }
-                tmp.push_back((*cur_iter));
+    for (Element::ptr child : el_ptr->m_children) {
+        if (child->get_display() != disp) {
+            // Leading whitespace is not wrapped.
+            if (!child->is_whitespace() || !tmp.empty()) {
+                tmp.push_back(child);
+            } else {
+                children.push_back(child);
             }
-            cur_iter++;
-        } else if (!tmp.empty()) {
-            flush_elements();
         } else {
-            cur_iter++;
+            if (!tmp.empty()) {
+                children.push_back(create_anonymous_box(el_ptr, tmp, disp_str));
+                tmp.clear();
+            }
+            children.push_back(child);
         }
     }
     if (!tmp.empty()) {
-        flush_elements();
+        children.push_back(create_anonymous_box(el_ptr, tmp, disp_str));
     }
+
+    el_ptr->m_children.swap(children);
 }
 
 void Document::fix_table_parent(Element::ptr& el_ptr,
@@ -816,64 +1249,58 @@ void Document::fix_table_parent(Element::ptr& el_ptr,
 {
     Element::ptr parent = el_ptr->parent();
 
-    if (parent->get_display() != disp) {
-        ElementsVector::iterator this_element =
-            std::find_if(parent->m_children.begin(),
-                parent->m_children.end(),
-                [&](Element::ptr& el) {
-                    if (el == el_ptr) {
-                        return true;
-                    }
-                    return false;
-                });
-        if (this_element != parent->m_children.end()) {
-            Display el_disp = el_ptr->get_display();
-            ElementsVector::iterator first = this_element;
-            ElementsVector::iterator last = this_element;
-            ElementsVector::iterator cur = this_element;
-
-            // find first element with same display
-            while (true) {
-                if (cur == parent->m_children.begin())
-                    break;
-                cur--;
-                if ((*cur)->is_whitespace() || (*cur)->get_display() == el_disp) {
-                    first = cur;
-                } else {
-                    break;
-                }
-            }
+    if (parent->get_display() == disp) {
+        return;
+    }
 
-            // find last element with same display
-            cur = this_element;
-            while (true) {
-                cur++;
-                if (cur == parent->m_children.end())
-                    break;
+    // Wrap every run of siblings with the same display as this element (and
+    // the whitespace around them) at once, rather than only the run that
+    // contains this element. The siblings that are processed later then
+    // already have the right parent, so each parent is rebuilt only once.
+    Display el_disp = el_ptr->get_display();
+    ElementsVector children;
+    children.reserve(parent->m_children.size());
+    ElementsVector tmp;
+    bool wrap = false;
 
-                if ((*cur)->is_whitespace() || (*cur)->get_display() == el_disp) {
-                    last = cur;
-                } else {
-                    break;
-                }
-            }
+    auto flush_elements = [&]() {
+        if (wrap) {
+            children.push_back(create_anonymous_box(parent, tmp, disp_str));
+        } else {
+            children.insert(children.end(), tmp.begin(), tmp.end());
+        }
+        tmp.clear();
+        wrap = false;
+    };
 
-            // extract elements with the same display and wrap them with anonymous object
-            Element* annon_tag = new HTMLElement(this);
-            CSSStyle st;
-            st.add_property(kCSSPropertyDisplay, disp_str, URL(), false);
-            annon_tag->add_style(st);
-            annon_tag->parent(parent);
-            annon_tag->parse_styles();
-            std::for_each(first, last + 1, [&annon_tag](Element* element) {
-                if (!annon_tag->append_child(element)) {
-                    delete element;
-                }
-            });
-            first = parent->m_children.erase(first, last + 1);
-            parent->m_children.insert(first, annon_tag);
+    for (Element::ptr child : parent->m_children) {
+        if (child->is_whitespace()) {
+            tmp.push_back(child);
+        } else if (child->get_display() == el_disp) {
+            tmp.push_back(child);
+            wrap = true;
+        } else {
+            flush_elements();
+            children.push_back(child);
         }
     }
+    flush_elements();
+
+    parent->m_children.swap(children);
+}
+
+Element::ptr Document::create_anonymous_box(Element::ptr parent,
+    ElementsVector& children,
+    const char* disp_str)
+{
+    Element::ptr annon_tag = new HTMLElement(this);
+    CSSStyle st;
+    st.add_property(kCSSPropertyDisplay, disp_str, URL(), false);
+    annon_tag->add_style(st);
+    annon_tag->parent(parent);
+    annon_tag->parse_styles();
+    annon_tag->append_children(children);
+    return annon_tag;
 }
 
 void Document::append_children_from_string(Element& parent, const char* str)
@@ -913,7 +1340,7 @@ void Document::append_children_from_utf8(Element& parent, const char* str)
         child->apply_stylesheet(stylesheet_);
 
         // Parse applied styles in the elements
-        child->parse_styles();
+        parse_styles(child);
 
         // Now the m_tabular_elements is filled with tabular elements.
         // We have to check the tabular elements for missing table elements
@@ -29,3 +29,16 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "litehtml/document_container.h"
+
+namespace litehtml {
+
+void DocumentContainer::measure_texts(const TextRun* runs,
+    size_t count,
+    int* widths)
+{
+    for (size_t i = 0; i < count; i++) {
+        widths[i] = text_width(runs[i].text, runs[i].font);
+    }
+}
+
+} // namespace litehtml
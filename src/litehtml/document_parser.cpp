@@ -39,7 +39,7 @@ namespace litehtml {
 Document* DocumentParser::parse(const String& html,
     const URL& base_url,
     DocumentContainer* container,
-    Context* context,
+    const Context* context,
     CSSStylesheet* user_stylesheet)
 {
     return parse(html.data(),
@@ -53,7 +53,7 @@ Document* DocumentParser::parse(const String& html,
 Document* DocumentParser::parse(const char* html,
     const URL& base_url,
     DocumentContainer* container,
-    Context* context,
+    const Context* context,
     CSSStylesheet* user_stylesheet)
 {
     return parse(html,
@@ -68,7 +68,7 @@ Document* DocumentParser::parse(const char* html,
     size_t length,
     const URL& base_url,
     DocumentContainer* container,
-    Context* context,
+    const Context* context,
     CSSStylesheet* user_stylesheet)
 {
     // Parse the HTML using gumbo_parse_with_options() with the default
@@ -81,6 +81,10 @@ Document* DocumentParser::parse(const char* html,
     // Create the document.
     Document* document = new Document(base_url, container, context);
 
+    // The text is split into words (using the line break rules for the
+    // document language) as the nodes are created.
+    document->update_language();
+
     // Convert the Gumbo elements into litehtml elements.
     ElementsVector root_elements;
     document->create_node(output->root, root_elements, true);
@@ -107,18 +111,12 @@ Document* DocumentParser::parse(const char* html,
 
         // Parse stylesheets linked from document.
         MediaQueryList::ptr media = nullptr;
-        for (auto& css : document->m_css) {
-            if (!css.media.empty()) {
-                media = MediaQueryList::create_from_string(css.media, document);
-            }
-
-            document->stylesheet_.parse(css.text, css.baseurl, document, media);
-        }
         for (css_text::vector::iterator css = document->m_css.begin();
              css != document->m_css.end();
              css++) {
             if (!css->media.empty()) {
                 media = MediaQueryList::create_from_string(css->media, document);
+                document->add_media_list(media);
             } else {
                 media = nullptr;
             }
@@ -145,7 +143,7 @@ Document* DocumentParser::parse(const char* html,
         }
 
         // Parse applied styles in the elements.
-        document->root_->parse_styles();
+        document->parse_styles(document->root_.get());
 
         // Now the m_tabular_elements is filled with tabular elements.
         // We have to check the tabular elements for missing table elements
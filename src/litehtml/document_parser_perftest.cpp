@@ -30,7 +30,9 @@
 #include <assert.h>
 #include <benchmark/benchmark.h>
 
+#include <algorithm>
 #include <fstream>
+#include <thread>
 
 #include "litehtml/document.h"
 #include "litehtml/document_parser.h"
@@ -73,3 +75,112 @@ void DocumentPerfTestCreate(benchmark::State& state)
 }
 
 BENCHMARK(DocumentPerfTestCreate);
+
+void DocumentPerfTestClone(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context;
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    for (auto _ : state) {
+        Document* clone = document->clone();
+        delete clone;
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestClone);
+
+// Parse and render documents concurrently with a single shared Context.
+void DocumentPerfTestCreateSharedContext(benchmark::State& state)
+{
+    static const std::string html = load("../test/html/obama.html");
+    static const Context context;
+
+    test_container container;
+
+    for (auto _ : state) {
+        Document* document = DocumentParser::parse(html, URL(), &container, &context);
+        document->render(1024);
+        delete document;
+    }
+}
+
+BENCHMARK(DocumentPerfTestCreateSharedContext)
+    ->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))
+    ->UseRealTime();
+
+namespace {
+
+// Returns a CSS table (built from div elements) with the given number of
+// cells and no row group elements, so parsing has to create anonymous table
+// boxes for the rows (or row groups) that are missing.
+std::string css_table(int cells, int cells_per_row)
+{
+    std::string html = "<html><body><div style=\"display: table\">";
+    for (int i = 0; i < cells; i++) {
+        if (cells_per_row && i % cells_per_row == 0) {
+            if (i) {
+                html += "</div>";
+            }
+            html += "<div style=\"display: table-row\">";
+        }
+        html += "<div style=\"display: table-cell\">cell</div>";
+    }
+    if (cells_per_row && cells) {
+        html += "</div>";
+    }
+    html += "</div></body></html>";
+    return html;
+}
+
+} // namespace
+
+// Table rows without a row group (the table gets an anonymous row group).
+void DocumentPerfTestTableFixupRows(benchmark::State& state)
+{
+    std::string html = css_table(state.range(0), 10);
+
+    test_container container;
+    Context context;
+
+    for (auto _ : state) {
+        Document* document = DocumentParser::parse(html, URL(), &container, &context);
+        delete document;
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(DocumentPerfTestTableFixupRows)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+// Table cells without rows or a row group (the table gets an anonymous row
+// group and an anonymous row).
+void DocumentPerfTestTableFixupCells(benchmark::State& state)
+{
+    std::string html = css_table(state.range(0), 0);
+
+    test_container container;
+    Context context;
+
+    for (auto _ : state) {
+        Document* document = DocumentParser::parse(html, URL(), &container, &context);
+        delete document;
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(DocumentPerfTestTableFixupCells)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
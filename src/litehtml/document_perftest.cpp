@@ -0,0 +1,583 @@
+// Copyright (C) 2020-2021 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the names of the copyright holders nor the names of their
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "litehtml/display_list.h"
+#include "litehtml/document.h"
+#include "litehtml/document_parser.h"
+#include "litehtml/element/html_element.h"
+#include "litehtml/render_tree.h"
+#include "test_container.h"
+
+using namespace litehtml;
+
+namespace {
+
+const char* master_css =
+#include "master.css.inc"
+    ;
+
+// The widths responsive pages are typically rendered at.
+const std::vector<int> responsive_widths = {320, 768, 1280, 1920};
+
+std::string load(const std::string& filename)
+{
+    std::ifstream ifs(filename.c_str());
+
+    if (ifs.bad()) {
+        assert(false);
+    }
+
+    std::string text;
+    char c;
+    while (ifs.get(c)) {
+        text += c;
+    }
+
+    return text;
+}
+
+// Returns a page with count floats of different heights, alternating between
+// the left and the right side, with paragraphs of text wrapping around them.
+std::string floats_html(int count)
+{
+    std::string html = "<html><body>";
+    for (int i = 0; i < count; i++) {
+        html += "<div style=\"float: ";
+        html += (i % 3 == 2) ? "right" : "left";
+        html += "; width: 120px; height: ";
+        html += std::to_string(40 + (i * 37) % 80);
+        html += "px\"></div>";
+        if (i % 4 == 3) {
+            html += "<p>Text that wraps around the floats next to it, line "
+                    "after line, until the floats end.</p>";
+        }
+    }
+    html += "</body></html>";
+    return html;
+}
+
+// Returns a page with inline-blocks nested depth levels deep, each holding an
+// icon next to the inline-block nested inside it. The test container has an
+// empty client rectangle and measures all text as zero width, so the page
+// sets the width of the root element and sizes the icons explicitly.
+std::string nested_inline_blocks_html(int depth)
+{
+    std::string html = "<html style=\"width: 1024px\"><body>";
+    for (int i = 0; i < depth; i++) {
+        html += "<div style=\"display: inline-block; padding: 2px\">";
+        html += "<span style=\"display: inline-block; width: 16px\"></span> ";
+    }
+    for (int i = 0; i < depth; i++) {
+        html += "</div>";
+    }
+    html += "</body></html>";
+    return html;
+}
+
+// Returns a page with a table of rows rows and cols columns, with an
+// automatic or a fixed ('table-layout: fixed') layout. Like above, the cell
+// contents are sized explicitly, but the root element is as wide as the
+// width the page is rendered at.
+std::string table_html(int rows, int cols, bool fixed)
+{
+    std::string html = "<html style=\"width: auto\"><body><table style=\"";
+    html += fixed ? "width: 800px; table-layout: fixed" : "width: auto";
+    html += "\">";
+    for (int i = 0; i < rows; i++) {
+        html += "<tr>";
+        for (int j = 0; j < cols; j++) {
+            html += "<td><span style=\"display: inline-block; width: ";
+            html += std::to_string(20 + (i * 7 + j * 13) % 60);
+            html += "px\"></span> <span style=\"display: inline-block; "
+                    "width: 30px\"></span></td>";
+        }
+        html += "</tr>";
+    }
+    html += "</table></body></html>";
+    return html;
+}
+
+} // namespace
+
+// Lay out the whole document on every iteration.
+void DocumentPerfTestRender(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    for (auto _ : state) {
+        document->invalidate_layout();
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRender);
+
+// Render a document that hasn't changed at the same width again.
+void DocumentPerfTestRenderRepeat(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    for (auto _ : state) {
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderRepeat);
+
+// Restyle a single element (as hovering over it would) and render again.
+void DocumentPerfTestRenderRestyle(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    Element* element = document->root()->select_one("li");
+    assert(element);
+
+    bool add = true;
+    for (auto _ : state) {
+        element->set_class("hover", add);
+        element->refresh_styles();
+        element->parse_styles();
+        document->render(1024);
+        add = !add;
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderRestyle);
+
+// Append a paragraph to the end of the document and render again.
+void DocumentPerfTestRenderAppend(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    Element* body = document->root()->select_one("body");
+    assert(body);
+
+    for (auto _ : state) {
+        document->append_children_from_string(*body,
+            "<p>An appended paragraph.</p>");
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderAppend);
+
+// Lay out a page with many floats in the same block formatting context.
+void DocumentPerfTestRenderFloats(benchmark::State& state)
+{
+    std::string html = floats_html(state.range(0));
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    for (auto _ : state) {
+        document->invalidate_layout();
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderFloats)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Lay out inline-blocks nested inside each other. Each inline-block is sized
+// to fit its contents (shrink-to-fit).
+void DocumentPerfTestRenderNestedInlineBlocks(benchmark::State& state)
+{
+    std::string html = nested_inline_blocks_html(state.range(0));
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    for (auto _ : state) {
+        document->invalidate_layout();
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderNestedInlineBlocks)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(12)
+    ->Arg(16)
+    ->Arg(20);
+
+// Lay out a table with an automatic layout, which measures every cell before
+// deciding the column widths.
+void DocumentPerfTestRenderTable(benchmark::State& state)
+{
+    std::string html = table_html(state.range(0), 4, false);
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    for (auto _ : state) {
+        document->invalidate_layout();
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderTable)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Lay out a table with a fixed layout, which renders every cell once.
+void DocumentPerfTestRenderTableFixed(benchmark::State& state)
+{
+    std::string html = table_html(state.range(0), 4, true);
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    for (auto _ : state) {
+        document->invalidate_layout();
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderTableFixed)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Render a table that hasn't changed at alternating widths, like when
+// resizing a window.
+void DocumentPerfTestRenderTableResize(benchmark::State& state)
+{
+    std::string html = table_html(state.range(0), 4, false);
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    int i = 0;
+    for (auto _ : state) {
+        document->render((i++ % 2) ? 900 : 1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderTableResize)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Lay out a wide table on state.range(0) threads (see
+// Document::set_layout_threads()).
+void DocumentPerfTestRenderWideTable(benchmark::State& state)
+{
+    std::string html = table_html(100, 50, false);
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->set_layout_threads(state.range(0));
+
+    for (auto _ : state) {
+        document->invalidate_layout();
+        document->render(1024);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderWideTable)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+// Parse and lay out the document once for every width.
+void DocumentPerfTestParseRenderWidths(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    for (auto _ : state) {
+        for (int width : responsive_widths) {
+            Document* document =
+                DocumentParser::parse(html, URL(), &container, &context);
+            document->render(width);
+            delete document;
+        }
+    }
+}
+
+BENCHMARK(DocumentPerfTestParseRenderWidths);
+
+// Lay out a parsed document at every width (see Document::render_widths()).
+void DocumentPerfTestRenderWidths(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    for (auto _ : state) {
+        for (Document* rendered : document->render_widths(responsive_widths)) {
+            delete rendered;
+        }
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderWidths);
+
+// Build the render tree snapshot of a laid out document.
+void DocumentPerfTestBuildRenderTree(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    RenderTree tree;
+    for (auto _ : state) {
+        tree.build(document->root());
+    }
+
+    state.counters["boxes"] = (double)tree.boxes().size();
+    state.counters["bytes_per_box"] =
+        (double)tree.memory_usage() / (double)tree.boxes().size();
+    state.counters["bytes_per_element"] = (double)sizeof(HTMLElement);
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestBuildRenderTree);
+
+// Find the element at ten points down the page with the render tree.
+void DocumentPerfTestRenderTreeBoxAt(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+    const RenderTree& tree = document->render_tree();
+
+    for (auto _ : state) {
+        for (int i = 0; i < 10; i++) {
+            int y = document->height() * i / 10;
+            benchmark::DoNotOptimize(tree.box_at(300, y));
+        }
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestRenderTreeBoxAt);
+
+// Find the element at the same points the way the document does, with the
+// paint order of its stacking contexts.
+void DocumentPerfTestElementByPoint(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    for (auto _ : state) {
+        for (int i = 0; i < 10; i++) {
+            int y = document->height() * i / 10;
+            benchmark::DoNotOptimize(
+                document->root()->get_element_by_point(300, y, 300, y));
+        }
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestElementByPoint);
+
+// Draw the document, either whole (state.range(0) == 0), the first 1024x768
+// of it (1), or 1024x768 from the middle of it (2).
+void DocumentPerfTestDraw(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    int top = state.range(0) == 2 ? document->height() / 2 : 0;
+    Position viewport(0, top, 1024, 768);
+    const Position* clip = state.range(0) ? &viewport : nullptr;
+    for (auto _ : state) {
+        document->draw((uintptr_t)0, 0, 0, clip);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestDraw)->Arg(0)->Arg(1)->Arg(2);
+
+// Change the color of an element back and forth, and draw the document again,
+// either whole (state.range(0) == 0) or only where it changed (1). The test
+// container measures text as empty, so the element is one of the divs that
+// are sized by their padding and borders.
+void DocumentPerfTestDrawRestyle(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+    html.insert(html.find("</head>"), "<style>.changed { color: red }</style>");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+    document->set_track_damage(state.range(0) == 1);
+
+    ElementsVector divs;
+    for (Element* div : document->root()->select_all("div")) {
+        Position placement = div->get_placement();
+        if (placement.width > 0 && placement.height > 0) {
+            divs.push_back(div);
+        }
+    }
+    assert(!divs.empty());
+    Element* element = divs[divs.size() / 2];
+
+    bool add = true;
+    long long damage = 0;
+    for (auto _ : state) {
+        element->set_class("changed", add);
+        element->refresh_styles();
+        element->parse_styles();
+        document->render(1024);
+        if (state.range(0) == 1) {
+            damage += document->damage().area();
+            document->draw((uintptr_t)0, 0, 0, document->damage());
+            document->clear_damage();
+        } else {
+            document->draw((uintptr_t)0, 0, 0, nullptr);
+        }
+        add = !add;
+    }
+
+    if (state.range(0) == 1) {
+        state.counters["damage"] =
+            benchmark::Counter((double)damage, benchmark::Counter::kAvgIterations);
+    }
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestDrawRestyle)->Arg(0)->Arg(1);
+
+// Replay the recorded draw calls of the document, either all of them or the
+// ones that draw in the first 1024x768 of it.
+void DocumentPerfTestReplay(benchmark::State& state)
+{
+    std::string html = load("../test/html/obama.html");
+
+    test_container container;
+    Context context(master_css);
+
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+
+    DisplayList list;
+    list.record(document, 0, 0);
+
+    Position viewport(0, 0, 1024, 768);
+    const Position* clip = state.range(0) ? &viewport : nullptr;
+    for (auto _ : state) {
+        list.replay(&container, (uintptr_t)0, clip);
+    }
+
+    state.counters["items"] = (double)list.size();
+
+    delete document;
+}
+
+BENCHMARK(DocumentPerfTestReplay)->Arg(0)->Arg(1);
@@ -29,13 +29,79 @@
 
 #include "litehtml/document.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "litehtml/document_parser.h"
 #include "test_container.h"
 
+#if defined(USE_ICU)
+#include "unicode/brkiter.h"
+#include "unicode/utext.h"
+#endif
+
 using namespace litehtml;
 
+namespace {
+
+// A container that logs the text drawn on it.
+class text_logging_container : public test_container {
+public:
+    std::vector<std::string> texts;
+
+    virtual void draw_text(uintptr_t,
+        const char* text,
+        uintptr_t,
+        Color,
+        const Position&) override
+    {
+        texts.push_back(text);
+    }
+};
+
+// A container for Japanese.
+class japanese_container : public test_container {
+public:
+    virtual void get_language(std::string& language,
+        std::string& culture) const override
+    {
+        language = "ja";
+        culture = "JP";
+    }
+};
+
+// A container with a 1024x768 window.
+class window_container : public test_container {
+public:
+    virtual Position get_client_rect() const override
+    {
+        return Position(0, 0, 1024, 768);
+    }
+};
+
+// A container with a 1024x768 window and 100x50 images that records the
+// backgrounds drawn on it.
+class background_container : public window_container {
+public:
+    std::vector<BackgroundPaint> backgrounds;
+
+    virtual Size get_image_size(const URL&) override
+    {
+        return Size(100, 50);
+    }
+
+    virtual void draw_background(uintptr_t, const BackgroundPaint& bg) override
+    {
+        backgrounds.push_back(bg);
+    }
+};
+
+} // namespace
+
 TEST(DocumentTest, AddFont)
 {
     test_container container;
@@ -155,3 +221,914 @@ TEST(DocumentTest, OuterHtml)
         EXPECT_EQ(testcase, document->outer_html());
     }
 }
+
+TEST(DocumentTest, Clone)
+{
+    std::string html =
+        "<html><head><style>p { margin: 10px; }</style></head>"
+        "<body><p>Hello</p>"
+        "<table><tr><td>a</td><td>b</td></tr></table></body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html,
+        URL(),
+        &container,
+        &context);
+    Document* clone = document->clone();
+
+    EXPECT_EQ(document->outer_html(), clone->outer_html());
+
+    document->render(100);
+    clone->render(100);
+
+    EXPECT_EQ(document->width(), clone->width());
+    EXPECT_EQ(document->height(), clone->height());
+
+    // Elements in the clone belong to the clone.
+    Element* p = clone->root()->select_one("p");
+    ASSERT_NE(nullptr, p);
+    EXPECT_EQ(clone, p->get_document());
+    EXPECT_EQ(10, p->margin().left);
+
+    // Mutating the clone does not affect the original document.
+    clone->append_children_from_string(*p, "<span>World</span>");
+    EXPECT_NE(document->outer_html(), clone->outer_html());
+
+    delete clone;
+
+    // The original document remains usable after the clone is destroyed.
+    document->render(100);
+    Position position(0, 0, 100, 100);
+    document->draw((uintptr_t)0, 0, 0, &position);
+
+    delete document;
+}
+
+TEST(DocumentTest, SplitText)
+{
+    std::vector<std::string> testcases = {
+        "<html><head></head><body><p>plain ascii  text</p></body></html>",
+        "<html><head></head><body><p>caf\xc3\xa9 na\xc3\xafve \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e</p></body></html>",
+    };
+
+    for (auto& testcase : testcases) {
+        Context context;
+        test_container container;
+        Document* document = DocumentParser::parse(
+            testcase,
+            URL(),
+            &container,
+            &context);
+
+        // Splitting the text into text elements must not lose (or garble)
+        // any of the text.
+        EXPECT_EQ(testcase, document->outer_html());
+
+        Element* p = document->root()->select_one("p");
+        ASSERT_NE(nullptr, p);
+        EXPECT_GT(p->get_children_count(), 1u);
+
+        delete document;
+    }
+}
+
+TEST(DocumentTest, SplitTextLanguage)
+{
+    std::string html =
+        "<html><head></head><body>"
+        "<p>\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae"
+        "\xe6\x96\x87\xe7\xab\xa0</p></body></html>";
+
+    Context context;
+    japanese_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    EXPECT_TRUE(document->match_lang("ja-JP"));
+
+#if defined(USE_ICU)
+    // The text was split with the line break iterator for the document
+    // language (so that iterator has been moved past the start of the text).
+    icu::BreakIterator* break_iterator = document->line_break_iterator();
+    ASSERT_NE(nullptr, break_iterator);
+    EXPECT_GT(break_iterator->current(), 0);
+#endif
+
+    delete document;
+}
+
+TEST(DocumentTest, SplitTextPunctuation)
+{
+    std::string html =
+        "<html><head></head><body><p>well-known and/or</p></body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    EXPECT_EQ(html, document->outer_html());
+
+    Element* p = document->root()->select_one("p");
+    ASSERT_NE(nullptr, p);
+#if defined(USE_ICU)
+    // ICU may also break after a hyphen or a slash: "well-", "known ",
+    // "and/", "or".
+    EXPECT_EQ(4u, p->get_children_count());
+#else
+    // Without ICU, the text only breaks at whitespace: "well-known", " ",
+    // "and/or".
+    EXPECT_EQ(3u, p->get_children_count());
+#endif
+
+    delete document;
+}
+
+#if defined(USE_ICU)
+TEST(DocumentTest, SplitTextMatchesICU)
+{
+    // Text that split_text_node() splits without ICU must be split exactly
+    // as the ICU line break iterator splits it.
+    std::vector<std::pair<std::string, std::string>> testcases = {
+        {"foo bar", "foo bar"},
+        {"  leading and trailing  ", "  leading and trailing  "},
+        {"a .b a .9 a ,b a :b a ;b", "a .b a .9 a ,b a :b a ;b"},
+        {"x ) y ] w", "x ) y ] w"},
+        {"x) y] it's \"q\" #1 &amp; *a* =b @c ^d _e `f ~g",
+            "x) y] it's \"q\" #1 & *a* =b @c ^d _e `f ~g"},
+        {"&lt;b&gt; 1,000.50 12:30; end.", "<b> 1,000.50 12:30; end."},
+    };
+
+    for (auto& testcase : testcases) {
+        std::string html = "<html><head></head><body><p>" + testcase.first +
+            "</p></body></html>";
+
+        Context context;
+        test_container container;
+        Document* document =
+            DocumentParser::parse(html, URL(), &container, &context);
+
+        Element* p = document->root()->select_one("p");
+        ASSERT_NE(nullptr, p);
+        std::vector<std::string> actual;
+        for (size_t i = 0; i < p->get_children_count(); i++) {
+            std::string text;
+            p->get_child(i)->get_text(text);
+            actual.push_back(text);
+        }
+
+        const std::string& text = testcase.second;
+        UErrorCode code = U_ZERO_ERROR;
+        std::unique_ptr<icu::BreakIterator> break_iterator(
+            icu::BreakIterator::createLineInstance(icu::Locale("en"), code));
+        ASSERT_TRUE(U_SUCCESS(code));
+        UText* utext = utext_openUTF8(nullptr, text.data(), text.size(), &code);
+        break_iterator->setText(utext, code);
+        ASSERT_TRUE(U_SUCCESS(code));
+        std::vector<std::string> expected;
+        int32_t start = break_iterator->first();
+        for (int32_t end = break_iterator->next();
+             end != icu::BreakIterator::DONE;
+             start = end, end = break_iterator->next()) {
+            expected.push_back(text.substr(start, end - start));
+        }
+        utext_close(utext);
+
+        EXPECT_EQ(expected, actual) << text;
+
+        delete document;
+    }
+}
+#endif
+
+TEST(DocumentTest, AnonymousTableBoxes)
+{
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(
+        "<html><body><div id=\"table\" style=\"display: table\">"
+        "<div style=\"display: table-cell\">a</div> "
+        "<p>b</p> "
+        "<div style=\"display: table-cell\">c</div>"
+        "</div></body></html>",
+        URL(),
+        &container,
+        &context);
+
+    Element* table = document->root()->select_one("#table");
+    ASSERT_NE(nullptr, table);
+
+    // The table gets an anonymous row group that holds all of its children.
+    ASSERT_EQ(1u, table->get_children_count());
+    Element* row_group = table->get_child(0);
+    EXPECT_EQ(kDisplayTableRowGroup, row_group->get_display());
+
+    // Each run of cells (with the whitespace around it) is wrapped in an
+    // anonymous row, and so is the paragraph between them.
+    ASSERT_EQ(3u, row_group->get_children_count());
+    for (size_t i = 0; i < row_group->get_children_count(); i++) {
+        Element* row = row_group->get_child(i);
+        EXPECT_EQ(kDisplayTableRow, row->get_display());
+        EXPECT_EQ(row_group, row->parent());
+    }
+    EXPECT_EQ(2u, row_group->get_child(0)->get_children_count());
+    EXPECT_EQ(2u, row_group->get_child(2)->get_children_count());
+
+    // The paragraph is wrapped in an anonymous cell.
+    Element* row = row_group->get_child(1);
+    ASSERT_EQ(1u, row->get_children_count());
+    EXPECT_EQ(kDisplayTableCell, row->get_child(0)->get_display());
+    EXPECT_STREQ("p", row->get_child(0)->get_child(0)->get_tagName());
+
+    delete document;
+}
+
+TEST(DocumentTest, RenderCache)
+{
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(
+        "<html><head><style>"
+        "body, div, p { display: block }"
+        "#block:hover { margin-left: 30px }"
+        "</style></head><body>"
+        "<div id=\"float\" style=\"float: left\">float</div>"
+        "<div id=\"block\" style=\"overflow: hidden\"><p>text</p></div>"
+        "</body></html>",
+        URL(),
+        &container,
+        &context);
+
+    Element* block = document->root()->select_one("#block");
+    ASSERT_NE(nullptr, block);
+
+    EXPECT_TRUE(document->root()->needs_layout());
+    int width = document->render(500);
+    EXPECT_FALSE(document->root()->needs_layout());
+    EXPECT_FALSE(block->needs_layout());
+    Position position = block->get_position();
+
+    // Rendering again at the same width reuses the layout.
+    EXPECT_EQ(width, document->render(500));
+    EXPECT_EQ(position.x, block->get_position().x);
+    EXPECT_EQ(position.y, block->get_position().y);
+    EXPECT_EQ(position.width, block->get_position().width);
+
+    // Rendering at a different width and back gives the same layout.
+    document->render(200);
+    EXPECT_EQ(width, document->render(500));
+    EXPECT_EQ(position.x, block->get_position().x);
+    EXPECT_EQ(position.y, block->get_position().y);
+    EXPECT_EQ(position.width, block->get_position().width);
+
+    // Restyling an element marks it and its ancestors as needing layout.
+    block->set_pseudo_class("hover", true);
+    block->refresh_styles();
+    block->parse_styles();
+    EXPECT_TRUE(block->needs_layout());
+    EXPECT_TRUE(document->root()->needs_layout());
+    document->render(500);
+    EXPECT_FALSE(block->needs_layout());
+    EXPECT_EQ(30, block->margin().left);
+
+    // Invalidating the document discards the layout of every element.
+    document->invalidate_layout();
+    EXPECT_TRUE(document->root()->needs_layout());
+    document->render(500);
+    EXPECT_EQ(30, block->margin().left);
+
+    delete document;
+}
+
+TEST(DocumentTest, RenderCachePercentHeight)
+{
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(
+        "<html><head><style>"
+        "body, div { display: block }"
+        "#outer { height: 200px }"
+        "#outer:hover { height: 400px }"
+        "#inner { height: 50% }"
+        "</style></head><body>"
+        "<div id=\"outer\"><div id=\"inner\"></div></div>"
+        "</body></html>",
+        URL(),
+        &container,
+        &context);
+
+    Element* outer = document->root()->select_one("#outer");
+    Element* inner = document->root()->select_one("#inner");
+    document->render(500);
+    EXPECT_EQ(100, inner->get_position().height);
+
+    // Restyling only the parent changes the height the child's percentage
+    // height is resolved against, so the child is laid out again.
+    outer->set_pseudo_class("hover", true);
+    outer->refresh_styles();
+    outer->parse_styles(true);
+    EXPECT_FALSE(inner->needs_layout());
+    document->render(500);
+    EXPECT_EQ(400, outer->get_position().height);
+    EXPECT_EQ(200, inner->get_position().height);
+
+    delete document;
+}
+
+TEST(DocumentTest, RenderCacheHidden)
+{
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(
+        "<html><head><style>"
+        "body, div, p { display: block }"
+        "#hidden { display: none }"
+        "#hidden:hover { display: block; height: 50px }"
+        "</style></head><body>"
+        "<div id=\"parent\"><div id=\"hidden\"><p>text</p></div></div>"
+        "</body></html>",
+        URL(),
+        &container,
+        &context);
+
+    Element* parent = document->root()->select_one("#parent");
+    Element* hidden = document->root()->select_one("#hidden");
+    document->render(500);
+
+    // The hidden element isn't rendered, so it is still marked while its
+    // ancestors aren't.
+    EXPECT_TRUE(hidden->needs_layout());
+    EXPECT_FALSE(parent->needs_layout());
+
+    // Restyling it marks its ancestors again.
+    hidden->set_pseudo_class("hover", true);
+    hidden->refresh_styles();
+    hidden->parse_styles();
+    EXPECT_TRUE(parent->needs_layout());
+    EXPECT_TRUE(document->root()->needs_layout());
+    document->render(500);
+    EXPECT_EQ(50, parent->get_position().height);
+
+    delete document;
+}
+
+TEST(DocumentTest, IncrementalLayout)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, div, p { display: block }"
+        "p { margin: 10px }"
+        "</style></head><body>"
+        "<div id=\"first\"><p>first</p></div>"
+        "<div id=\"second\"><p>second</p></div>"
+        "</body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+
+    Element* body = document->root()->select_one("body");
+    Element* first = document->root()->select_one("#first");
+    Element* second = document->root()->select_one("#second");
+    ASSERT_NE(nullptr, body);
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+
+    // Mutating an element marks it and its ancestors, but not its siblings.
+    EXPECT_TRUE(second->set_class("changed", true));
+    EXPECT_TRUE(second->needs_layout());
+    EXPECT_TRUE(body->needs_layout());
+    EXPECT_FALSE(first->needs_layout());
+    document->render(500);
+    EXPECT_FALSE(second->needs_layout());
+
+    EXPECT_TRUE(first->set_pseudo_class("hover", true));
+    EXPECT_TRUE(first->needs_layout());
+    EXPECT_FALSE(second->needs_layout());
+    document->render(500);
+
+    document->append_children_from_string(*first, "<p>appended</p>");
+    EXPECT_TRUE(first->needs_layout());
+    EXPECT_FALSE(second->needs_layout());
+    document->render(500);
+
+    // The incremental layout matches the layout of a fresh document.
+    Document* expected = DocumentParser::parse(html, URL(), &container, &context);
+    Element* expected_first = expected->root()->select_one("#first");
+    expected->append_children_from_string(*expected_first, "<p>appended</p>");
+    expected->render(500);
+    Element* expected_second = expected->root()->select_one("#second");
+
+    EXPECT_EQ(expected->height(), document->height());
+    EXPECT_EQ(expected_first->get_position().height, first->get_position().height);
+    EXPECT_EQ(expected_second->get_position().y, second->get_position().y);
+    EXPECT_GT(second->get_position().y, 0);
+
+    delete expected;
+    delete document;
+}
+
+TEST(DocumentTest, ShrinkToFit)
+{
+    std::string html =
+        "<html><head><style>"
+        "body { display: block }"
+        "div { display: inline-block; padding: 2px }"
+        "span { display: inline-block; width: 16px; height: 16px }"
+        "</style></head><body>"
+        "<div id=\"outer\"><span></span> "
+        "<div><span></span> <div id=\"inner\"><span></span> <span></span>"
+        "</div></div></div>"
+        "</body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    // Render at different widths; the nested inline-blocks fit in all of
+    // them, so the later renders reuse the widths found by the first.
+    document->render(500);
+    document->render(300);
+    document->render(400);
+
+    Element* outer = document->root()->select_one("#outer");
+    Element* inner = document->root()->select_one("#inner");
+    ASSERT_NE(nullptr, outer);
+    ASSERT_NE(nullptr, inner);
+
+    // Each inline-block is as wide as its contents.
+    EXPECT_EQ(32, inner->get_position().width);
+    EXPECT_EQ(72, outer->get_position().width);
+
+    Document* expected = DocumentParser::parse(html, URL(), &container, &context);
+    expected->render(400);
+    Element* expected_outer = expected->root()->select_one("#outer");
+    Element* expected_inner = expected->root()->select_one("#inner");
+
+    EXPECT_EQ(expected_outer->get_position().width, outer->get_position().width);
+    EXPECT_EQ(expected_inner->get_position().x, inner->get_position().x);
+    EXPECT_EQ(expected_inner->get_position().y, inner->get_position().y);
+
+    delete expected;
+    delete document;
+}
+
+TEST(DocumentTest, TableLayoutFixed)
+{
+    std::string html =
+        "<html><head><style>"
+        "body { display: block }"
+        "table { display: table; width: 300px; border-spacing: 0 }"
+        "tbody { display: table-row-group }"
+        "tr { display: table-row }"
+        "td { display: table-cell }"
+        "span { display: inline-block; width: 250px; height: 16px }"
+        "</style></head><body>"
+        "<table id=\"auto\"><tr>"
+        "<td id=\"auto1\" style=\"width: 100px\"></td><td id=\"auto2\"><span></span></td><td></td>"
+        "</tr></table>"
+        "<table id=\"fixed\" style=\"table-layout: fixed\"><tr>"
+        "<td id=\"fixed1\" style=\"width: 100px\"></td><td id=\"fixed2\"><span></span></td><td></td>"
+        "</tr></table>"
+        "<table id=\"rows\" style=\"table-layout: fixed\"><tr>"
+        "<td id=\"rows1\" style=\"width: 100px\"></td><td></td><td></td>"
+        "</tr><tr>"
+        "<td style=\"width: 50px\"></td><td id=\"rows2\" style=\"width: 150px\"></td><td></td>"
+        "</tr></table>"
+        "</body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+
+    // The automatic layout widens the table to fit the contents.
+    EXPECT_EQ(350, document->root()->select_one("#auto")->get_position().width);
+    EXPECT_EQ(100, document->root()->select_one("#auto1")->get_position().width);
+    EXPECT_EQ(250, document->root()->select_one("#auto2")->get_position().width);
+
+    // The fixed layout shares the width left by the first column between
+    // the other columns, whatever their contents.
+    EXPECT_EQ(300, document->root()->select_one("#fixed")->get_position().width);
+    EXPECT_EQ(100, document->root()->select_one("#fixed1")->get_position().width);
+    EXPECT_EQ(100, document->root()->select_one("#fixed2")->get_position().width);
+
+    // Only the first row sets the column widths of a fixed layout.
+    EXPECT_EQ(100, document->root()->select_one("#rows1")->get_position().width);
+    EXPECT_EQ(100, document->root()->select_one("#rows2")->get_position().width);
+
+    delete document;
+}
+
+TEST(DocumentTest, TableHugeRowspan)
+{
+    std::string html =
+        "<html><head><style>"
+        "body { display: block }"
+        "table { display: table; border-spacing: 0 }"
+        "tbody { display: table-row-group }"
+        "tr { display: table-row }"
+        "td { display: table-cell; width: 100px; height: 10px }"
+        "</style></head><body><table>"
+        "<tr><td></td><td></td></tr>"
+        "<tr><td></td><td></td></tr>"
+        "<tr><td rowspan=\"2147483647\"></td><td></td></tr>"
+        "<tr><td id=\"shifted\"></td></tr>"
+        "</table></body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+
+    // The cell spans the remaining rows, so the cell in the next row goes in
+    // the second column.
+    EXPECT_EQ(100, document->root()->select_one("#shifted")->get_position().x);
+
+    delete document;
+}
+
+TEST(DocumentTest, TableRerender)
+{
+    std::string html =
+        "<html><head><style>"
+        "body { display: block }"
+        "table { display: table }"
+        "tbody { display: table-row-group }"
+        "tr { display: table-row; vertical-align: middle }"
+        "td { display: table-cell; vertical-align: inherit }"
+        "span { display: inline-block; width: 100px; height: 16px }"
+        "</style></head><body><table><tr>"
+        "<td><span></span> <span></span> <span></span></td>"
+        "<td><span id=\"middle\"></span></td>"
+        "</tr></table></body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    // The later renders reuse the cell widths measured by the first one.
+    document->render(600);
+    document->render(250);
+    document->render(500);
+    document->render(250);
+
+    Document* expected = DocumentParser::parse(html, URL(), &container, &context);
+    expected->render(250);
+
+    Position position = document->root()->select_one("#middle")->get_position();
+    Position expected_position =
+        expected->root()->select_one("#middle")->get_position();
+
+    // The cell is vertically centered only once.
+    EXPECT_EQ(expected_position.x, position.x);
+    EXPECT_EQ(expected_position.y, position.y);
+    EXPECT_EQ(expected->height(), document->height());
+
+    delete expected;
+    delete document;
+}
+
+TEST(DocumentTest, LayoutThreads)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, div { display: block }"
+        "table { display: table }"
+        "tbody { display: table-row-group }"
+        "tr { display: table-row }"
+        "td { display: table-cell }"
+        "span { display: inline-block; height: 16px }"
+        ".abs { position: absolute; width: 50% }"
+        "</style></head><body><table>";
+    for (int row = 0; row < 20; row++) {
+        html += "<tr>";
+        for (int col = 0; col < 8; col++) {
+            html += "<td><span style=\"width: " +
+                    std::to_string(10 + (row * 8 + col) * 7 % 90) +
+                    "px\"></span> <span style=\"width: 40px\"></span></td>";
+        }
+        html += "</tr>";
+    }
+    html += "</table>";
+    for (int i = 0; i < 8; i++) {
+        html += "<div class=\"abs\" style=\"top: " + std::to_string(i * 20) +
+                "px\"><span style=\"width: 300px\"></span></div>";
+    }
+    html += "</body></html>";
+
+    Context context;
+    test_container container;
+    Document* serial = DocumentParser::parse(html, URL(), &container, &context);
+    Document* parallel = DocumentParser::parse(html, URL(), &container, &context);
+    parallel->set_layout_threads(4);
+    EXPECT_EQ(4, parallel->layout_threads());
+
+    for (int width : {1000, 600, 300}) {
+        serial->render(width);
+        parallel->render(width);
+
+        // The layout doesn't depend on the number of threads.
+        ElementsVector serial_spans = serial->root()->select_all("span");
+        ElementsVector parallel_spans = parallel->root()->select_all("span");
+        ASSERT_EQ(serial_spans.size(), parallel_spans.size());
+        for (size_t i = 0; i < serial_spans.size(); i++) {
+            Position expected = serial_spans[i]->get_placement();
+            Position actual = parallel_spans[i]->get_placement();
+            EXPECT_EQ(expected.x, actual.x);
+            EXPECT_EQ(expected.y, actual.y);
+            EXPECT_EQ(expected.width, actual.width);
+        }
+        EXPECT_EQ(serial->width(), parallel->width());
+        EXPECT_EQ(serial->height(), parallel->height());
+    }
+
+    delete parallel;
+    delete serial;
+}
+
+TEST(DocumentTest, RenderWidths)
+{
+    std::string html =
+        "<html><head><style>"
+        "html, body, div { display: block }"
+        "html { width: 100% }"
+        "div { height: 10px }"
+        "</style>"
+        "<style media=\"(min-width:600px)\">div { width: 200px }</style>"
+        "<style media=\"(min-width:1000px)\">div { margin-left: 50px }</style>"
+        "</head><body><div></div></body></html>";
+
+    // The widths differ from the width of the container's window.
+    Context context;
+    window_container container;
+    Document* document = DocumentParser::parse(html,
+        URL(),
+        &container,
+        &context);
+
+    std::vector<Document*> documents =
+        document->render_widths({320, 768, 1280, 1920});
+    ASSERT_EQ(4u, documents.size());
+
+    // Each document is laid out at its own width, with the media queries
+    // that apply at that width.
+    struct {
+        int width;
+        int div_width;
+        int div_margin;
+    } expected[] = {
+        {320, 320, 0},
+        {768, 200, 0},
+        {1280, 200, 50},
+        {1920, 200, 50},
+    };
+    for (size_t i = 0; i < documents.size(); i++) {
+        EXPECT_NE(document, documents[i]);
+        Element* div = documents[i]->root()->select_one("div");
+        ASSERT_NE(nullptr, div);
+        EXPECT_EQ(documents[i], div->get_document());
+        EXPECT_EQ(expected[i].width, documents[i]->width());
+        EXPECT_EQ(expected[i].width,
+            documents[i]->root()->get_position().width);
+        EXPECT_EQ(expected[i].div_width, div->get_position().width);
+        EXPECT_EQ(expected[i].div_margin, div->margin().left);
+    }
+
+    // The original document still uses the container's window.
+    document->render(1024);
+    EXPECT_EQ(1024, document->root()->get_position().width);
+    Element* div = document->root()->select_one("div");
+    EXPECT_EQ(200, div->get_position().width);
+    EXPECT_EQ(50, div->margin().left);
+
+    for (Document* rendered : documents) {
+        delete rendered;
+    }
+    delete document;
+}
+
+TEST(DocumentTest, DrawPaintOrder)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, div { display: block }"
+        ".under { position: relative; z-index: -1 }"
+        ".over { position: absolute; z-index: 1 }"
+        ".top { position: relative; z-index: 2 }"
+        "</style></head><body>"
+        "<div class=\"over\">over</div>"
+        "<div class=\"under\">under</div>"
+        "<div>block</div>"
+        "</body></html>";
+
+    Context context;
+    text_logging_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+
+    std::vector<std::string> expected = {"under", "block", "over"};
+    document->draw(0, 0, 0, nullptr);
+    EXPECT_EQ(expected, container.texts);
+
+    // The paint order found by the first draw is reused.
+    container.texts.clear();
+    document->draw(0, 0, 0, nullptr);
+    EXPECT_EQ(expected, container.texts);
+
+    // The paint order is found again after the layout changes.
+    Element* body = document->root()->select_one("body");
+    document->append_children_from_string(*body, "<div class=\"top\">top</div>");
+    document->render(500);
+
+    expected = {"under", "block", "over", "top"};
+    container.texts.clear();
+    document->draw(0, 0, 0, nullptr);
+    EXPECT_EQ(expected, container.texts);
+
+    delete document;
+}
+
+TEST(DocumentTest, DrawClip)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, div { display: block }"
+        "div { height: 100px }"
+        "</style></head><body>";
+    for (int i = 0; i < 100; i++) {
+        html += "<div>" + std::to_string(i) + "</div>";
+    }
+    html += "</body></html>";
+
+    Context context;
+    text_logging_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+
+    // Only the text in (or touching) the clip is drawn.
+    Position clip(0, 5050, 500, 150);
+    document->draw(0, 0, 0, &clip);
+    std::vector<std::string> expected = {"51", "52"};
+    EXPECT_EQ(expected, container.texts);
+
+    container.texts.clear();
+    document->draw(0, 0, -1000, &clip);
+    expected = {"61", "62"};
+    EXPECT_EQ(expected, container.texts);
+
+    delete document;
+}
+
+TEST(DocumentTest, Damage)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, div { display: block }"
+        "div { height: 100px }"
+        "div:hover { color: red }"
+        "#grow:hover { height: 150px }"
+        "</style></head><body>";
+    for (int i = 0; i < 10; i++) {
+        html += "<div>" + std::to_string(i) + "</div>";
+    }
+    html += "<div id=\"grow\">10</div><div>11</div></body></html>";
+
+    Context context;
+    text_logging_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+    document->set_track_damage(true);
+
+    // Nothing has changed yet.
+    document->render(500);
+    EXPECT_TRUE(document->damage().empty());
+
+    // Hovering over a div only damages the div.
+    std::vector<Position> redraw;
+    document->on_mouse_over(10, 550, 10, 550, redraw);
+    document->render(500);
+    ASSERT_EQ(1u, document->damage().rects().size());
+    Position rect = document->damage().rects()[0];
+    EXPECT_EQ(0, rect.x);
+    EXPECT_EQ(500, rect.y);
+    EXPECT_EQ(500, rect.width);
+    EXPECT_EQ(100, rect.height);
+
+    // Only the text in (or touching) the damage is drawn again.
+    document->draw(0, 0, 0, document->damage());
+    std::vector<std::string> expected = {"5", "6"};
+    EXPECT_EQ(expected, container.texts);
+    document->clear_damage();
+
+    // A div that grows damages the div after it, and the body it grows.
+    document->on_mouse_over(10, 1050, 10, 1050, redraw);
+    document->render(500);
+    Position bounds = document->damage().bounds();
+    EXPECT_EQ(0, bounds.y);
+    EXPECT_EQ(1250, bounds.height);
+
+    delete document;
+}
+
+TEST(DocumentTest, DamageListItem)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, ul { display: block }"
+        "li { display: list-item; list-style-type: disc; height: 100px }"
+        "li:hover { background-color: #eee }"
+        "</style></head><body><ul>"
+        "<li>0</li><li>1</li><li>2</li>"
+        "</ul></body></html>";
+
+    Context context;
+    text_logging_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+    document->set_track_damage(true);
+
+    // Hovering over a list item damages the list item, and the marker on
+    // either side of it.
+    std::vector<Position> redraw;
+    document->on_mouse_over(10, 150, 10, 150, redraw);
+    document->render(500);
+    ASSERT_FALSE(document->damage().empty());
+    Position bounds = document->damage().bounds();
+    EXPECT_LE(bounds.x, 0);
+    EXPECT_GE(bounds.right(), 500);
+    EXPECT_LE(bounds.y, 100);
+    EXPECT_GE(bounds.bottom(), 200);
+
+    delete document;
+}
+
+TEST(DocumentTest, BackgroundFixed)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, div { display: block }"
+        "div { margin: 100px 0 0 300px; width: 200px; height: 100px;"
+        " background-image: url(a.png); background-position: 50% 50%;"
+        " background-repeat: no-repeat }"
+        "#fixed { background-attachment: fixed }"
+        "</style></head><body>"
+        "<div id=\"scroll\"></div><div id=\"fixed\"></div>"
+        "</body></html>";
+
+    Context context;
+    background_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(1024);
+    document->draw(0, 0, 0, nullptr);
+
+    ASSERT_EQ(2u, container.backgrounds.size());
+
+    // A scrolling background is centred in the element.
+    const BackgroundPaint& scroll = container.backgrounds[0];
+    EXPECT_EQ(300 + (200 - 100) / 2, scroll.position_x);
+    EXPECT_EQ(scroll.clip_box.y + (100 - 50) / 2, scroll.position_y);
+
+    // A fixed background is centred in the window, and clipped to the
+    // element.
+    const BackgroundPaint& fixed = container.backgrounds[1];
+    EXPECT_EQ((1024 - 100) / 2, fixed.position_x);
+    EXPECT_EQ((768 - 50) / 2, fixed.position_y);
+    EXPECT_EQ(300, fixed.clip_box.x);
+    EXPECT_EQ(200, fixed.clip_box.width);
+
+    delete document;
+}
+
+TEST(DocumentTest, ElementByPoint)
+{
+    std::string html =
+        "<html><head><style>"
+        "body, div, p { display: block }"
+        "body { height: 600px }"
+        "div { position: absolute; top: 0; left: 0; width: 100px; height: 100px }"
+        "#high { z-index: 2 }"
+        "#low { z-index: 1; width: 200px }"
+        "#clip { top: 200px; overflow: hidden }"
+        "p { height: 300px }"
+        "</style></head><body>"
+        "<div id=\"high\"></div>"
+        "<div id=\"low\"></div>"
+        "<div id=\"clip\"><p id=\"inside\"></p></div>"
+        "</body></html>";
+
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+    document->render(500);
+
+    Element* root = document->root();
+    EXPECT_EQ(root->select_one("#high"), root->get_element_by_point(50, 50, 50, 50));
+    EXPECT_EQ(root->select_one("#low"), root->get_element_by_point(150, 50, 150, 50));
+    EXPECT_EQ(root->select_one("#inside"),
+        root->get_element_by_point(50, 250, 50, 250));
+
+    // The part of #inside below the clip can't be hit.
+    EXPECT_EQ(root->select_one("body"),
+        root->get_element_by_point(50, 400, 50, 400));
+
+    delete document;
+}
@@ -44,6 +44,11 @@ AnchorElement::~AnchorElement()
 {
 }
 
+Element* AnchorElement::clone(Document* document) const
+{
+    return clone_children(new AnchorElement(*this), document);
+}
+
 void AnchorElement::on_click()
 {
     const char* href = get_attr("href");
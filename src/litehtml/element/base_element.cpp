@@ -44,6 +44,11 @@ BaseElement::~BaseElement()
 {
 }
 
+Element* BaseElement::clone(Document* document) const
+{
+    return clone_children(new BaseElement(*this), document);
+}
+
 void BaseElement::parse_attributes()
 {
     URL base_url(get_attr("href"));
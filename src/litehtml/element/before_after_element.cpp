@@ -204,8 +204,18 @@ BeforeElement::~BeforeElement()
 {
 }
 
+Element* BeforeElement::clone(Document* document) const
+{
+    return clone_children(new BeforeElement(*this), document);
+}
+
 AfterElement::~AfterElement()
 {
 }
 
+Element* AfterElement::clone(Document* document) const
+{
+    return clone_children(new AfterElement(*this), document);
+}
+
 } // namespace litehtml
@@ -43,6 +43,11 @@ BodyElement::~BodyElement()
 {
 }
 
+Element* BodyElement::clone(Document* document) const
+{
+    return clone_children(new BodyElement(*this), document);
+}
+
 bool BodyElement::is_body() const
 {
     return true;
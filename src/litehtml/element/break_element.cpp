@@ -40,6 +40,11 @@ BreakElement::~BreakElement()
 {
 }
 
+Element* BreakElement::clone(Document* document) const
+{
+    return clone_children(new BreakElement(*this), document);
+}
+
 bool BreakElement::is_break() const
 {
     return true;
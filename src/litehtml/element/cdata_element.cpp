@@ -42,6 +42,11 @@ CDATAElement::~CDATAElement()
 {
 }
 
+Element* CDATAElement::clone(Document* document) const
+{
+    return clone_children(new CDATAElement(*this), document);
+}
+
 void CDATAElement::get_text(std::string& text) const
 {
     text += m_text;
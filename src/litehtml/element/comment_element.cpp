@@ -42,6 +42,11 @@ CommentElement::~CommentElement()
 {
 }
 
+Element* CommentElement::clone(Document* document) const
+{
+    return clone_children(new CommentElement(*this), document);
+}
+
 void CommentElement::get_text(std::string& text) const
 {
     text += m_text;
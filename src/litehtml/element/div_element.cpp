@@ -41,6 +41,11 @@ DivElement::~DivElement()
 {
 }
 
+Element* DivElement::clone(Document* document) const
+{
+    return clone_children(new DivElement(*this), document);
+}
+
 void DivElement::parse_attributes()
 {
     const char* str = get_attr("align");
@@ -102,6 +102,20 @@ Element::Element(Document* document)
 {
 }
 
+Element::Element(const Element& element)
+: std::enable_shared_from_this<Element>()
+, m_doc(element.m_doc)
+, m_parent(nullptr)
+, m_box(nullptr)
+, position_(element.position_)
+, margin_(element.margin_)
+, border_(element.border_)
+, padding_(element.padding_)
+, direction_(element.direction_)
+, m_skip(element.m_skip)
+{
+}
+
 Element::~Element()
 {
     for (auto child : m_children) {
@@ -109,6 +123,40 @@ Element::~Element()
     }
 }
 
+Element* Element::clone(Document* document) const
+{
+    return clone_children(new Element(*this), document);
+}
+
+Element* Element::clone_children(Element* copy, Document* document) const
+{
+    copy->m_doc = document;
+    copy->m_children.reserve(m_children.size());
+    for (auto child : m_children) {
+        Element* child_copy = child->clone(document);
+        child_copy->m_parent = copy;
+        copy->m_children.push_back(child_copy);
+    }
+    return copy;
+}
+
+void Element::invalidate_layout()
+{
+    // The layout of an element depends on the layout of its descendants, so
+    // mark every ancestor too. An element marked since the last render had
+    // its ancestors marked at the same time, so stop there. An element marked
+    // before the last render may still be marked (e.g., if it isn't
+    // displayed, it isn't rendered) while its ancestors were rendered since.
+    int count = m_doc->layout_count();
+    for (Element* element = this; element; element = element->m_parent) {
+        if (element->layout_dirty_ && element->layout_dirty_count_ == count) {
+            break;
+        }
+        element->layout_dirty_ = true;
+        element->layout_dirty_count_ = count;
+    }
+}
+
 
 // https://html.spec.whatwg.org/multipage/dom.html#the-dir-attribute
 Directionality Element::get_directionality() const
@@ -247,7 +295,7 @@ bool Element::get_predefined_height(int& p_height) const
     if (h.units() == kCSSUnitsPercent) {
         Element::ptr el_parent = parent();
         if (!el_parent) {
-            Position client_pos = get_document()->container()->get_client_rect();
+            Position client_pos = get_document()->client_rect();
             p_height = h.calc_percent(client_pos.height);
             return true;
         } else {
@@ -304,7 +352,7 @@ int Element::calc_width(int defVal) const
     if (w.units() == kCSSUnitsPercent) {
         Element::ptr el_parent = parent();
         if (!el_parent) {
-            Position client_pos = get_document()->container()->get_client_rect();
+            Position client_pos = get_document()->client_rect();
             return w.calc_percent(client_pos.width);
         } else {
             int pw = el_parent->calc_width(defVal);
@@ -513,6 +561,14 @@ void Element::draw_children(uintptr_t,
 {
 }
 
+void Element::add_paint_steps(std::vector<PaintStep>&,
+    int,
+    int,
+    DrawFlag,
+    int)
+{
+}
+
 void Element::draw_stacking_context(uintptr_t,
     int,
     int,
@@ -669,6 +725,16 @@ bool Element::is_floats_holder() const
     return false;
 }
 
+bool Element::is_intrinsically_sized() const
+{
+    return false;
+}
+
+size_t Element::get_floats_count() const
+{
+    return 0;
+}
+
 Size Element::get_content_size(int)
 {
     return Size();
@@ -847,6 +913,33 @@ void Element::draw_background(uintptr_t, int, int, const Position*)
 {
 }
 
+bool Element::get_draw_bounds(Position& bounds)
+{
+    // The same boxes as is_point_inside().
+    if (get_display() != kDisplayInline && get_display() != kDisplayTableRow) {
+        bounds = position_;
+        bounds += padding_;
+        bounds += border_;
+    } else {
+        std::vector<Position> boxes;
+        get_inline_boxes(boxes);
+        bounds = Position();
+        for (size_t i = 0; i < boxes.size(); i++) {
+            if (i == 0) {
+                bounds = boxes[i];
+            } else {
+                bounds.unite(boxes[i]);
+            }
+        }
+    }
+    return true;
+}
+
+bool Element::get_paint_bounds(bool, Position& bounds)
+{
+    return get_draw_bounds(bounds);
+}
+
 const char* Element::get_style_property(CSSProperty)
 {
     return nullptr;
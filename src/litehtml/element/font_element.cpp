@@ -41,6 +41,11 @@ FontElement::~FontElement()
 {
 }
 
+Element* FontElement::clone(Document* document) const
+{
+    return clone_children(new FontElement(*this), document);
+}
+
 void FontElement::parse_attributes()
 {
     const char* str = get_attr("color");
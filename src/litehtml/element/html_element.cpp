@@ -46,6 +46,15 @@
 
 namespace litehtml {
 
+namespace {
+
+// Paint orders with at least this many steps are indexed by bands of
+// kPaintBandHeight pixels (see HTMLElement::find_paint_steps()).
+const size_t kMinIndexedPaintSteps = 64;
+const int kPaintBandHeight = 256;
+
+} // namespace
+
 HTMLElement::HTMLElement(Document* doc)
 : Element(doc)
 {
@@ -70,17 +79,77 @@ HTMLElement::HTMLElement(Document* doc)
     m_border_spacing_x = 0;
     m_border_spacing_y = 0;
     m_border_collapse = border_collapse_separate;
+    table_layout_ = kTableLayoutAuto;
+}
+
+HTMLElement::HTMLElement(const HTMLElement& element)
+: Element(element)
+, m_class_values(element.m_class_values)
+, m_tag(element.m_tag)
+, m_style(element.m_style)
+, m_attrs(element.m_attrs)
+, vertical_align_(element.vertical_align_)
+, m_text_align(element.m_text_align)
+, m_display(element.m_display)
+, list_style_type_(element.list_style_type_)
+, list_style_position_(element.list_style_position_)
+, white_space_(element.white_space_)
+, m_float(element.m_float)
+, m_clear(element.m_clear)
+, m_bg(element.m_bg)
+, m_el_position(element.m_el_position)
+, line_height_(element.line_height_)
+, m_lh_predefined(element.m_lh_predefined)
+, m_pseudo_classes(element.m_pseudo_classes)
+, font_(element.font_)
+, font_size_(element.font_size_)
+, font_metrics_(element.font_metrics_)
+, m_css_margins(element.m_css_margins)
+, m_css_padding(element.m_css_padding)
+, m_css_borders(element.m_css_borders)
+, m_css_width(element.m_css_width)
+, m_css_height(element.m_css_height)
+, m_css_min_width(element.m_css_min_width)
+, m_css_min_height(element.m_css_min_height)
+, m_css_max_width(element.m_css_max_width)
+, m_css_max_height(element.m_css_max_height)
+, m_css_offsets(element.m_css_offsets)
+, m_css_text_indent(element.m_css_text_indent)
+, overflow_(element.overflow_)
+, m_visibility(element.m_visibility)
+, m_z_index(element.m_z_index)
+, box_sizing_(element.box_sizing_)
+, m_css_border_spacing_x(element.m_css_border_spacing_x)
+, m_css_border_spacing_y(element.m_css_border_spacing_y)
+, m_border_spacing_x(element.m_border_spacing_x)
+, m_border_spacing_y(element.m_border_spacing_y)
+, m_border_collapse(element.m_border_collapse)
+, table_layout_(element.table_layout_)
+{
+    // The selectors themselves are immutable once the stylesheet is parsed
+    // so the copy can share them with the original element.
+    m_used_styles.reserve(element.m_used_styles.size());
+    for (const auto& us : element.m_used_styles) {
+        m_used_styles.push_back(std::unique_ptr<used_selector>(
+            new used_selector(us->m_selector, us->m_used)));
+    }
 }
 
 HTMLElement::~HTMLElement()
 {
 }
 
+Element* HTMLElement::clone(Document* document) const
+{
+    return clone_children(new HTMLElement(*this), document);
+}
+
 bool HTMLElement::append_child(Element* element)
 {
     if (element) {
         element->parent(this);
         m_children.push_back(element);
+        invalidate_layout();
         return true;
     }
     return false;
@@ -195,7 +264,7 @@ void HTMLElement::apply_stylesheet(const CSSStylesheet& stylesheet)
             used_selector::ptr us =
                 std::unique_ptr<used_selector>(new used_selector(sel, false));
 
-            if (sel->is_media_valid()) {
+            if (sel->is_media_valid(get_document())) {
                 if (apply & select_match_pseudo_class) {
                     if (select(*sel, true)) {
                         if (apply & select_match_with_after) {
@@ -330,6 +399,10 @@ const CSSValue* HTMLElement::get_style_property_value(CSSProperty property) cons
 
 void HTMLElement::parse_styles(bool is_reparse)
 {
+    // The styles may change the layout of the element, and how it's drawn.
+    invalidate_layout();
+    get_document()->element_changed(this);
+
     const char* style = get_attr("style");
 
     if (style) {
@@ -527,11 +600,64 @@ void HTMLElement::parse_styles(bool is_reparse)
 
 int HTMLElement::render(int x, int y, int max_width, bool second_pass)
 {
+    Document* doc = get_document();
+
+    // Floats holders are laid out independently of the floats around them.
+    // Other elements share the floats of their block formatting context, so
+    // their layout can only be reused if no float reaches down to them (and
+    // none of their descendants is placed in that context; see below).
+    bool floats_holder = is_floats_holder();
+    Element::ptr el_parent = parent();
+    bool float_free =
+        floats_holder || !el_parent || el_parent->get_floats_height() <= y;
+
+    // Percentage heights and offsets are resolved against the height of the
+    // parent, which may have changed without the element changing.
+    int containing_height = -1;
+    if (el_parent && !el_parent->get_predefined_height(containing_height)) {
+        containing_height = -1;
+    }
+
+    if (!layout_dirty_ && layout_cache_.valid && float_free &&
+        layout_cache_.generation == doc->layout_generation() &&
+        layout_cache_.max_width == max_width &&
+        layout_cache_.containing_height == containing_height &&
+        layout_cache_.second_pass == second_pass) {
+        // The parent may have changed the box model metrics (e.g., by calling
+        // calc_outlines()) since the last render, so restore them.
+        margin_ = layout_cache_.margin;
+        border_ = layout_cache_.border;
+        padding_ = layout_cache_.padding;
+        position_ = layout_cache_.position;
+        position_.move_to(x, y);
+        position_.x += content_margin_left();
+        position_.y += content_margin_top();
+        return layout_cache_.width;
+    }
+
+    size_t floats_count = floats_holder ? 0 : get_floats_count();
+
+    int ret_width = 0;
     if (m_display == kDisplayTable || m_display == kDisplayInlineTable) {
-        return render_table(x, y, max_width, second_pass);
-    }
+        ret_width = render_table(x, y, max_width, second_pass);
+    } else {
+        ret_width = render_box(x, y, max_width, second_pass);
+    }
+
+    layout_cache_.valid =
+        float_free && (floats_holder || get_floats_count() == floats_count);
+    layout_cache_.generation = doc->layout_generation();
+    layout_cache_.max_width = max_width;
+    layout_cache_.containing_height = containing_height;
+    layout_cache_.second_pass = second_pass;
+    layout_cache_.width = ret_width;
+    layout_cache_.position = position_;
+    layout_cache_.margin = margin_;
+    layout_cache_.border = border_;
+    layout_cache_.padding = padding_;
+    layout_dirty_ = false;
 
-    return render_box(x, y, max_width, second_pass);
+    return ret_width;
 }
 
 bool HTMLElement::is_whitespace() const
@@ -927,6 +1053,11 @@ Element::ptr HTMLElement::find_ancestor(const CSSSelector& selector,
 int HTMLElement::get_floats_height(ElementFloat el_float) const
 {
     if (is_floats_holder()) {
+        if (el_float == kFloatNone) {
+            return std::max(floats_index_.left_height(),
+                floats_index_.right_height());
+        }
+
         int h = 0;
 
         bool process = false;
@@ -1001,13 +1132,7 @@ int HTMLElement::get_floats_height(ElementFloat el_float) const
 int HTMLElement::get_left_floats_height() const
 {
     if (is_floats_holder()) {
-        int h = 0;
-        if (!m_floats_left.empty()) {
-            for (const auto& fb : m_floats_left) {
-                h = std::max(h, fb.pos.bottom());
-            }
-        }
-        return h;
+        return floats_index_.left_height();
     }
     Element::ptr el_parent = parent();
     if (el_parent) {
@@ -1020,13 +1145,7 @@ int HTMLElement::get_left_floats_height() const
 int HTMLElement::get_right_floats_height() const
 {
     if (is_floats_holder()) {
-        int h = 0;
-        if (!m_floats_right.empty()) {
-            for (const auto& fb : m_floats_right) {
-                h = std::max(h, fb.pos.bottom());
-            }
-        }
-        return h;
+        return floats_index_.right_height();
     }
     Element::ptr el_parent = parent();
     if (el_parent) {
@@ -1036,24 +1155,22 @@ int HTMLElement::get_right_floats_height() const
     return 0;
 }
 
-int HTMLElement::get_line_left(int y)
+size_t HTMLElement::get_floats_count() const
 {
     if (is_floats_holder()) {
-        if (m_cahe_line_left.is_valid && m_cahe_line_left.hash == y) {
-            return m_cahe_line_left.val;
-        }
+        return m_floats_left.size() + m_floats_right.size();
+    }
+    Element::ptr el_parent = parent();
+    if (el_parent) {
+        return el_parent->get_floats_count();
+    }
+    return 0;
+}
 
-        int w = 0;
-        for (const auto& fb : m_floats_left) {
-            if (y >= fb.pos.top() && y < fb.pos.bottom()) {
-                w = std::max(w, fb.pos.right());
-                if (w < fb.pos.right()) {
-                    break;
-                }
-            }
-        }
-        m_cahe_line_left.set_value(y, w);
-        return w;
+int HTMLElement::get_line_left(int y)
+{
+    if (is_floats_holder()) {
+        return floats_index_.line_left(y);
     }
     Element::ptr el_parent = parent();
     if (el_parent) {
@@ -1069,27 +1186,7 @@ int HTMLElement::get_line_left(int y)
 int HTMLElement::get_line_right(int y, int def_right)
 {
     if (is_floats_holder()) {
-        if (m_cahe_line_right.is_valid && m_cahe_line_right.hash == y) {
-            if (m_cahe_line_right.is_default) {
-                return def_right;
-            } else {
-                return std::min(m_cahe_line_right.val, def_right);
-            }
-        }
-
-        int w = def_right;
-        m_cahe_line_right.is_default = true;
-        for (const auto& fb : m_floats_right) {
-            if (y >= fb.pos.top() && y < fb.pos.bottom()) {
-                w = std::min(w, fb.pos.left());
-                m_cahe_line_right.is_default = false;
-                if (w > fb.pos.left()) {
-                    break;
-                }
-            }
-        }
-        m_cahe_line_right.set_value(y, w);
-        return w;
+        return floats_index_.line_right(y, def_right);
     }
     Element::ptr el_parent = parent();
     if (el_parent) {
@@ -1215,44 +1312,27 @@ void HTMLElement::add_float(const Element::ptr& el, int x, int y)
         fb.clear_floats = el->get_clear();
         fb.el = el;
 
+        // Keep left floats ordered by decreasing right edge and right floats
+        // by increasing left edge; floats with equal edges keep the order
+        // they were added in.
         if (fb.float_side == kFloatLeft) {
-            if (m_floats_left.empty()) {
-                m_floats_left.push_back(fb);
-            } else {
-                bool inserted = false;
-                for (floated_box::vector::iterator i = m_floats_left.begin();
-                     i != m_floats_left.end();
-                     i++) {
-                    if (fb.pos.right() > i->pos.right()) {
-                        m_floats_left.insert(i, std::move(fb));
-                        inserted = true;
-                        break;
-                    }
-                }
-                if (!inserted) {
-                    m_floats_left.push_back(std::move(fb));
-                }
-            }
-            m_cahe_line_left.invalidate();
+            floats_index_.add(fb);
+            auto i = std::upper_bound(m_floats_left.begin(),
+                m_floats_left.end(),
+                fb,
+                [](const floated_box& a, const floated_box& b) {
+                    return a.pos.right() > b.pos.right();
+                });
+            m_floats_left.insert(i, std::move(fb));
         } else if (fb.float_side == kFloatRight) {
-            if (m_floats_right.empty()) {
-                m_floats_right.push_back(std::move(fb));
-            } else {
-                bool inserted = false;
-                for (floated_box::vector::iterator i = m_floats_right.begin();
-                     i != m_floats_right.end();
-                     i++) {
-                    if (fb.pos.left() < i->pos.left()) {
-                        m_floats_right.insert(i, std::move(fb));
-                        inserted = true;
-                        break;
-                    }
-                }
-                if (!inserted) {
-                    m_floats_right.push_back(fb);
-                }
-            }
-            m_cahe_line_right.invalidate();
+            floats_index_.add(fb);
+            auto i = std::upper_bound(m_floats_right.begin(),
+                m_floats_right.end(),
+                fb,
+                [](const floated_box& a, const floated_box& b) {
+                    return a.pos.left() < b.pos.left();
+                });
+            m_floats_right.insert(i, std::move(fb));
         }
     } else {
         Element::ptr el_parent = parent();
@@ -1265,55 +1345,7 @@ void HTMLElement::add_float(const Element::ptr& el, int x, int y)
 int HTMLElement::find_next_line_top(int top, int width, int def_right)
 {
     if (is_floats_holder()) {
-        int new_top = top;
-        int_vector points;
-
-        for (const auto& fb : m_floats_left) {
-            if (fb.pos.top() >= top) {
-                if (find(points.begin(), points.end(), fb.pos.top()) ==
-                    points.end()) {
-                    points.push_back(fb.pos.top());
-                }
-            }
-            if (fb.pos.bottom() >= top) {
-                if (find(points.begin(), points.end(), fb.pos.bottom()) ==
-                    points.end()) {
-                    points.push_back(fb.pos.bottom());
-                }
-            }
-        }
-
-        for (const auto& fb : m_floats_right) {
-            if (fb.pos.top() >= top) {
-                if (find(points.begin(), points.end(), fb.pos.top()) ==
-                    points.end()) {
-                    points.push_back(fb.pos.top());
-                }
-            }
-            if (fb.pos.bottom() >= top) {
-                if (find(points.begin(), points.end(), fb.pos.bottom()) ==
-                    points.end()) {
-                    points.push_back(fb.pos.bottom());
-                }
-            }
-        }
-
-        if (!points.empty()) {
-            sort(points.begin(), points.end(), std::less<int>());
-            new_top = points.back();
-
-            for (auto pt : points) {
-                int pos_left = 0;
-                int pos_right = def_right;
-                get_line_left_right(pt, def_right, pos_left, pos_right);
-
-                if (pos_right - pos_left >= width) {
-                    new_top = pt;
-                    break;
-                }
-            }
-        }
-        return new_top;
+        return floats_index_.find_next_line_top(top, width, def_right);
     }
     Element::ptr el_parent = parent();
     if (el_parent) {
@@ -1632,7 +1664,7 @@ bool HTMLElement::find_styles_changes(std::vector<Position>& redraw_boxes, int x
     for (used_selector::vector::iterator iter = m_used_styles.begin();
          iter != m_used_styles.end() && !apply;
          iter++) {
-        if ((*iter)->m_selector->is_media_valid()) {
+        if ((*iter)->m_selector->is_media_valid(get_document())) {
             int res = select(*((*iter)->m_selector), true);
             if ((res == select_no_match && (*iter)->m_used) ||
                 (res == select_match && !(*iter)->m_used)) {
@@ -1665,7 +1697,7 @@ bool HTMLElement::find_styles_changes(std::vector<Position>& redraw_boxes, int x
 
         ret = true;
         refresh_styles();
-        parse_styles();
+        get_document()->parse_styles(this);
     }
     for (auto& el : m_children) {
         if (!el->skip()) {
@@ -1941,6 +1973,35 @@ void HTMLElement::draw_background(uintptr_t hdc, int x, int y, const Position* c
     }
 }
 
+bool HTMLElement::get_draw_bounds(Position& bounds)
+{
+    // draw_list_marker() may draw anywhere around the element.
+    if (m_display == kDisplayListItem &&
+        list_style_type_ != kListStyleTypeNone) {
+        return false;
+    }
+    return Element::get_draw_bounds(bounds);
+}
+
+bool HTMLElement::get_paint_bounds(bool with_positioned, Position& bounds)
+{
+    if (!get_draw_bounds(bounds)) {
+        return false;
+    }
+    if (!is_visible()) {
+        return true;
+    }
+
+    const PaintOrder& order = paint_order(with_positioned);
+    if (!order.bounded) {
+        return false;
+    }
+    if (!order.steps.empty()) {
+        bounds.unite(order.bounds);
+    }
+    return true;
+}
+
 int HTMLElement::render_inline(const Element::ptr& container, int max_width)
 {
     int ret_width = 0;
@@ -1974,6 +2035,7 @@ int HTMLElement::render_inline(const Element::ptr& container, int max_width)
             ret_width = rw;
         }
     }
+    intrinsically_sized_ = calc_intrinsically_sized();
     return ret_width;
 }
 
@@ -2216,6 +2278,9 @@ bool HTMLElement::set_pseudo_class(const char* pclass, bool add)
             ret = true;
         }
     }
+    if (ret) {
+        invalidate_layout();
+    }
     return ret;
 }
 
@@ -2250,6 +2315,7 @@ bool HTMLElement::set_class(const char* pclass, bool add)
         std::string class_string;
         join_string(class_string, m_class_values, " ");
         set_attr("class", class_string.c_str());
+        invalidate_layout();
 
         return true;
     } else {
@@ -2401,6 +2467,66 @@ bool HTMLElement::is_floats_holder() const
     return false;
 }
 
+bool HTMLElement::is_intrinsically_sized() const
+{
+    return intrinsically_sized_;
+}
+
+bool HTMLElement::is_shrink_to_fit() const
+{
+    return have_parent() &&
+           (m_display == kDisplayInlineBlock ||
+               (m_css_width.is_predefined() &&
+                   (m_float != kFloatNone || m_display == kDisplayTable ||
+                       m_el_position == kPositionAbsolute ||
+                       m_el_position == kPositionFixed)));
+}
+
+bool HTMLElement::calc_intrinsically_sized() const
+{
+    if (m_display != kDisplayBlock && m_display != kDisplayInlineBlock &&
+        m_display != kDisplayInline && m_display != kDisplayTableCell) {
+        return false;
+    }
+
+    // Percentages (and auto margins) depend on the available width.
+    auto percent = [](const CSSLength& length) {
+        return !length.is_predefined() && length.units() == kCSSUnitsPercent;
+    };
+    if (percent(m_css_width) || percent(m_css_min_width) ||
+        percent(m_css_max_width) || percent(m_css_text_indent) ||
+        m_css_margins.left.is_predefined() ||
+        m_css_margins.right.is_predefined() || percent(m_css_margins.left) ||
+        percent(m_css_margins.right) || percent(m_css_margins.top) ||
+        percent(m_css_margins.bottom) || percent(m_css_padding.left) ||
+        percent(m_css_padding.right) || percent(m_css_padding.top) ||
+        percent(m_css_padding.bottom) || percent(m_css_borders.left.width) ||
+        percent(m_css_borders.right.width) ||
+        percent(m_css_borders.top.width) ||
+        percent(m_css_borders.bottom.width)) {
+        return false;
+    }
+
+    // Floats, positioned elements, tables and replaced elements are placed
+    // or sized relative to the available width.
+    for (const auto& el : m_children) {
+        Display display = el->get_display();
+        if (display == kDisplayNone) {
+            continue;
+        }
+        if (display != kDisplayInline && display != kDisplayInlineBlock &&
+            display != kDisplayBlock && display != kDisplayInlineText) {
+            return false;
+        }
+        if (el->get_float() != kFloatNone ||
+            el->get_element_position() != kPositionStatic ||
+            !el->is_intrinsically_sized()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool HTMLElement::is_first_child_inline(const Element::ptr& el) const
 {
     if (!m_children.empty()) {
@@ -2534,6 +2660,8 @@ void HTMLElement::apply_vertical_align()
             for (size_t i = 0; i < m_boxes.size(); i++) {
                 m_boxes[i]->y_shift(add);
             }
+            // The boxes no longer match the cached layout.
+            layout_cache_.valid = false;
         }
     }
 }
@@ -2584,6 +2712,12 @@ void HTMLElement::init_BackgroundPaint(Position pos,
             break;
     }
 
+    // A fixed background is sized and positioned within the viewport rather
+    // than the element (but still clipped to the element).
+    if (bg->m_attachment == kBackgroundAttachmentFixed) {
+        bg_paint.origin_box = get_document()->client_rect();
+    }
+
     if (!bg_paint.image.empty()) {
         bg_paint.image_size = get_document()->container()->get_image_size(bg_paint.image);
         if (bg_paint.image_size.width && bg_paint.image_size.height) {
@@ -2715,8 +2849,7 @@ void HTMLElement::draw_list_marker(uintptr_t hdc, const Position& pos)
 
     if (list_style_position_ == kListStylePositionOutside) {
         if (list_style_type_ >= kListStyleTypeArmenian) {
-            auto tw_space =
-                get_document()->container()->text_width(" ", lm.font);
+            auto tw_space = get_document()->text_width(" ", lm.font);
             lm.pos.x = pos.x - tw_space * 2;
             lm.pos.width = tw_space;
         } else {
@@ -2731,8 +2864,7 @@ void HTMLElement::draw_list_marker(uintptr_t hdc, const Position& pos)
             get_document()->container()->draw_list_marker(hdc, lm);
         } else {
             marker_text += ".";
-            auto tw = get_document()->container()->text_width(marker_text.c_str(),
-                lm.font);
+            auto tw = get_document()->text_width(marker_text.c_str(), lm.font);
             auto text_pos = lm.pos;
             text_pos.move_to(text_pos.right() - tw, text_pos.y);
             text_pos.width = tw;
@@ -2797,12 +2929,298 @@ void HTMLElement::draw_children(uintptr_t hdc,
     const Position* clip,
     DrawFlag flag,
     int zindex)
+{
+    std::vector<PaintStep> steps;
+    add_paint_steps(steps, 0, 0, flag, zindex);
+    draw_paint_steps(hdc, x, y, clip, steps);
+}
+
+void HTMLElement::add_paint_steps(std::vector<PaintStep>& steps,
+    int x,
+    int y,
+    DrawFlag flag,
+    int zindex)
 {
     if (m_display == kDisplayTable || m_display == kDisplayInlineTable) {
-        draw_children_table(hdc, x, y, clip, flag, zindex);
+        add_paint_steps_table(steps, x, y, flag, zindex);
     } else {
-        draw_children_box(hdc, x, y, clip, flag, zindex);
+        add_paint_steps_box(steps, x, y, flag, zindex);
+    }
+}
+
+void HTMLElement::add_paint_step(std::vector<PaintStep>& steps,
+    PaintStep::Type type,
+    Element* element,
+    int x,
+    int y,
+    bool fixed,
+    bool with_positioned)
+{
+    PaintStep step;
+    step.type = type;
+    step.element = element;
+    step.x = x;
+    step.y = y;
+    step.fixed = fixed;
+    step.with_positioned = with_positioned;
+
+    // Fixed elements are drawn wherever the client rectangle is.
+    if (fixed) {
+        step.bounded = false;
+    } else if (type == PaintStep::kDrawStackingContext) {
+        step.bounded = element->get_paint_bounds(with_positioned, step.bounds);
+    } else {
+        step.bounded = element->get_draw_bounds(step.bounds);
+    }
+    step.bounds.x += x;
+    step.bounds.y += y;
+
+    steps.push_back(step);
+}
+
+const HTMLElement::PaintOrder& HTMLElement::paint_order(bool with_positioned)
+{
+    // The z-index passes add nothing without positioned descendants, so
+    // don't tell a float (drawn without them) from a hit test (with them).
+    if (m_positioned.empty()) {
+        with_positioned = false;
+    }
+
+    int layout_count = get_document()->layout_count();
+    if (paint_order_.layout_count == layout_count &&
+        paint_order_.with_positioned == with_positioned) {
+        return paint_order_;
+    }
+
+    std::vector<PaintStep>& steps = paint_order_.steps;
+    steps.clear();
+
+    std::map<int, bool> zindexes;
+    if (with_positioned) {
+        for (ElementsVector::iterator i = m_positioned.begin();
+             i != m_positioned.end();
+             i++) {
+            zindexes[(*i)->get_zindex()];
+        }
+
+        for (std::map<int, bool>::iterator idx = zindexes.begin();
+             idx != zindexes.end();
+             idx++) {
+            if (idx->first < 0) {
+                add_paint_steps(steps, 0, 0, kDrawPositioned, idx->first);
+            }
+        }
+    }
+    add_paint_steps(steps, 0, 0, kDrawBlock, 0);
+    add_paint_steps(steps, 0, 0, kDrawFloats, 0);
+    add_paint_steps(steps, 0, 0, kDrawInlines, 0);
+    if (with_positioned) {
+        for (std::map<int, bool>::iterator idx = zindexes.begin();
+             idx != zindexes.end();
+             idx++) {
+            if (idx->first == 0) {
+                add_paint_steps(steps, 0, 0, kDrawPositioned, idx->first);
+            }
+        }
+
+        for (std::map<int, bool>::iterator idx = zindexes.begin();
+             idx != zindexes.end();
+             idx++) {
+            if (idx->first > 0) {
+                add_paint_steps(steps, 0, 0, kDrawPositioned, idx->first);
+            }
+        }
+    }
+
+    paint_order_.bounded = true;
+    paint_order_.bounds = Position();
+    bool have_bounds = false;
+    for (const PaintStep& step : steps) {
+        if (!step.bounded) {
+            paint_order_.bounded = false;
+        } else if (!have_bounds) {
+            paint_order_.bounds = step.bounds;
+            have_bounds = true;
+        } else {
+            paint_order_.bounds.unite(step.bounds);
+        }
+    }
+
+    paint_order_.bands.clear();
+    if (steps.size() >= kMinIndexedPaintSteps) {
+        const Position& bounds = paint_order_.bounds;
+        paint_order_.bands.resize(bounds.height / kPaintBandHeight + 1);
+        int last_band = (int)paint_order_.bands.size() - 1;
+        for (int i = 0; i < (int)steps.size(); i++) {
+            int first = 0;
+            int last = last_band;
+            if (steps[i].bounded) {
+                first = (steps[i].bounds.top() - bounds.top()) / kPaintBandHeight;
+                last = (steps[i].bounds.bottom() - bounds.top()) / kPaintBandHeight;
+                first = std::max(0, std::min(first, last_band));
+                last = std::max(0, std::min(last, last_band));
+            }
+            for (int band = first; band <= last; band++) {
+                paint_order_.bands[band].push_back(i);
+            }
+        }
+    }
+
+    paint_order_.layout_count = layout_count;
+    paint_order_.with_positioned = with_positioned;
+    return paint_order_;
+}
+
+// Sets result to the indices of the steps of order that may draw between top
+// and bottom, in order.
+void HTMLElement::find_paint_steps(const PaintOrder& order,
+    int top,
+    int bottom,
+    std::vector<int>& result) const
+{
+    int last_band = (int)order.bands.size() - 1;
+    int first = (top - order.bounds.top()) / kPaintBandHeight;
+    int last = (bottom - order.bounds.top()) / kPaintBandHeight;
+    first = std::max(0, std::min(first, last_band));
+    last = std::max(0, std::min(last, last_band));
+
+    result.clear();
+    for (int band = first; band <= last; band++) {
+        result.insert(result.end(),
+            order.bands[band].begin(),
+            order.bands[band].end());
+    }
+    if (first != last) {
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+}
+
+void HTMLElement::draw_paint_steps(uintptr_t hdc,
+    int x,
+    int y,
+    const Position* clip,
+    const std::vector<PaintStep>& steps,
+    const std::vector<int>* indices)
+{
+    DocumentContainer* container = get_document()->container();
+
+    Position browser_wnd;
+    bool have_browser_wnd = false;
+
+    size_t count = indices ? indices->size() : steps.size();
+    for (size_t i = 0; i < count; i++) {
+        const PaintStep& step = steps[indices ? (*indices)[i] : i];
+
+        // Skip the steps that would draw nothing (and the descendants of the
+        // elements, if the step draws a stacking context).
+        if (clip && step.bounded) {
+            Position bounds = step.bounds;
+            bounds.x += x;
+            bounds.y += y;
+            if (!bounds.does_intersect(clip)) {
+                continue;
+            }
+        }
+
+        int step_x = x + step.x;
+        int step_y = y + step.y;
+        if (step.fixed) {
+            if (!have_browser_wnd) {
+                browser_wnd = get_document()->client_rect();
+                have_browser_wnd = true;
+            }
+            step_x = browser_wnd.x;
+            step_y = browser_wnd.y;
+        }
+
+        switch (step.type) {
+            case PaintStep::kDraw:
+                step.element->draw(hdc, step_x, step_y, clip);
+                break;
+            case PaintStep::kDrawStackingContext:
+                step.element->draw(hdc, step_x, step_y, clip);
+                step.element->draw_stacking_context(hdc,
+                    step_x,
+                    step_y,
+                    clip,
+                    step.with_positioned);
+                break;
+            case PaintStep::kDrawBackground:
+                step.element->draw_background(hdc, step_x, step_y, clip);
+                break;
+            case PaintStep::kSetClip:
+                static_cast<HTMLElement*>(step.element)->set_overflow_clip(step_x, step_y);
+                break;
+            case PaintStep::kDelClip:
+                container->del_clip();
+                break;
+        }
+    }
+}
+
+// Returns the element the last of the steps (or of the steps in indices)
+// that draws at (x, y) draws there, or null if none does.
+Element::ptr HTMLElement::get_paint_step_by_point(const std::vector<PaintStep>& steps,
+    const std::vector<int>* indices,
+    int x,
+    int y,
+    int client_x,
+    int client_y)
+{
+    // Whether (x, y) is outside each of the overflow clips the steps are in,
+    // innermost last, and how many of them it is outside of.
+    std::vector<bool> outside_clips;
+    int outside_count = 0;
+
+    size_t count = indices ? indices->size() : steps.size();
+    for (size_t i = count; i-- > 0;) {
+        const PaintStep& step = steps[indices ? (*indices)[i] : i];
+        if (step.bounded && !step.bounds.is_point_inside(x, y)) {
+            continue;
+        }
+
+        Element::ptr el = step.element;
+        int step_x = x - step.x;
+        int step_y = y - step.y;
+        if (step.fixed) {
+            step_x = client_x;
+            step_y = client_y;
+        }
+
+        // The steps are visited backwards, so a clip ends before it starts.
+        if (step.type == PaintStep::kDelClip) {
+            bool outside =
+                !static_cast<HTMLElement*>(el)->position_.is_point_inside(step_x, step_y);
+            outside_clips.push_back(outside);
+            outside_count += outside;
+            continue;
+        }
+        if (step.type == PaintStep::kSetClip) {
+            if (!outside_clips.empty()) {
+                outside_count -= outside_clips.back();
+                outside_clips.pop_back();
+            }
+            continue;
+        }
+        if (outside_count || !el->is_visible() ||
+            el->get_display() == kDisplayInlineText) {
+            continue;
+        }
+
+        Element::ptr ret = nullptr;
+        if (step.type == PaintStep::kDrawStackingContext) {
+            ret = el->get_element_by_point(step_x, step_y, client_x, client_y);
+        }
+        if (!ret && el->is_point_inside(step_x, step_y)) {
+            ret = el;
+        }
+        if (ret) {
+            return ret;
+        }
     }
+
+    return nullptr;
 }
 
 // Returns true if any children are "positioned" (i.e., the element position
@@ -2836,196 +3254,204 @@ int HTMLElement::get_zindex() const
     return m_z_index;
 }
 
-void HTMLElement::render_positioned()
+void HTMLElement::render_positioned_element(const Element::ptr& el,
+    const Position& wnd_position)
 {
-    Position wnd_position = get_document()->container()->get_client_rect();
+    ElementPosition position = el->get_element_position();
 
-    for (auto& el : m_positioned) {
-        ElementPosition position = el->get_element_position();
+    bool process = false;
+    if (el->get_display() != kDisplayNone) {
+        if (position == kPositionAbsolute || position == kPositionFixed) {
+            process = true;
+        }
+    }
 
-        bool process = false;
-        if (el->get_display() != kDisplayNone) {
-            if (position == kPositionAbsolute || position == kPositionFixed) {
-                process = true;
+    if (process) {
+        int parent_height = 0;
+        int parent_width = 0;
+        //int client_x = 0;
+        //int client_y = 0;
+        if (position == kPositionFixed) {
+            parent_height = wnd_position.height;
+            parent_width = wnd_position.width;
+            //client_x = wnd_position.left();
+            //client_y = wnd_position.top();
+        } else {
+            Element::ptr el_parent = el->parent();
+            if (el_parent) {
+                parent_height = el_parent->height();
+                parent_width = el_parent->width();
             }
         }
 
-        if (process) {
-            int parent_height = 0;
-            int parent_width = 0;
-            //int client_x = 0;
-            //int client_y = 0;
-            if (position == kPositionFixed) {
-                parent_height = wnd_position.height;
-                parent_width = wnd_position.width;
-                //client_x = wnd_position.left();
-                //client_y = wnd_position.top();
-            } else {
-                Element::ptr el_parent = el->parent();
-                if (el_parent) {
-                    parent_height = el_parent->height();
-                    parent_width = el_parent->width();
-                }
-            }
+        CSSLength css_left = el->get_css_left();
+        CSSLength css_right = el->get_css_right();
+        CSSLength css_top = el->get_css_top();
+        CSSLength css_bottom = el->get_css_bottom();
 
-            CSSLength css_left = el->get_css_left();
-            CSSLength css_right = el->get_css_right();
-            CSSLength css_top = el->get_css_top();
-            CSSLength css_bottom = el->get_css_bottom();
+        bool need_render = false;
 
-            bool need_render = false;
+        CSSLength el_w = el->get_css_width();
+        CSSLength el_h = el->get_css_height();
 
-            CSSLength el_w = el->get_css_width();
-            CSSLength el_h = el->get_css_height();
+        int new_width = -1;
+        int new_height = -1;
+        if (el_w.units() == kCSSUnitsPercent && parent_width) {
+            new_width = el_w.calc_percent(parent_width);
+            if (el->position_.width != new_width) {
+                need_render = true;
+                el->position_.width = new_width;
+            }
+        }
 
-            int new_width = -1;
-            int new_height = -1;
-            if (el_w.units() == kCSSUnitsPercent && parent_width) {
-                new_width = el_w.calc_percent(parent_width);
-                if (el->position_.width != new_width) {
-                    need_render = true;
-                    el->position_.width = new_width;
-                }
+        if (el_h.units() == kCSSUnitsPercent && parent_height) {
+            new_height = el_h.calc_percent(parent_height);
+            if (el->position_.height != new_height) {
+                need_render = true;
+                el->position_.height = new_height;
             }
+        }
+
+        bool cvt_x = false;
+        bool cvt_y = false;
 
-            if (el_h.units() == kCSSUnitsPercent && parent_height) {
-                new_height = el_h.calc_percent(parent_height);
-                if (el->position_.height != new_height) {
+        if (position == kPositionFixed) {
+            if (!css_left.is_predefined() || !css_right.is_predefined()) {
+                if (!css_left.is_predefined() && css_right.is_predefined()) {
+                    el->position_.x = css_left.calc_percent(parent_width) +
+                                  el->content_margin_left();
+                } else if (css_left.is_predefined() &&
+                           !css_right.is_predefined()) {
+                    el->position_.x =
+                        parent_width - css_right.calc_percent(parent_width) -
+                        el->position_.width - el->content_margin_right();
+                } else {
+                    el->position_.x = css_left.calc_percent(parent_width) +
+                                  el->content_margin_left();
+                    el->position_.width = parent_width -
+                                      css_left.calc_percent(parent_width) -
+                                      css_right.calc_percent(parent_width) -
+                                      (el->content_margin_left() +
+                                          el->content_margin_right());
                     need_render = true;
-                    el->position_.height = new_height;
                 }
             }
 
-            bool cvt_x = false;
-            bool cvt_y = false;
-
-            if (position == kPositionFixed) {
-                if (!css_left.is_predefined() || !css_right.is_predefined()) {
-                    if (!css_left.is_predefined() && css_right.is_predefined()) {
-                        el->position_.x = css_left.calc_percent(parent_width) +
-                                      el->content_margin_left();
-                    } else if (css_left.is_predefined() &&
-                               !css_right.is_predefined()) {
-                        el->position_.x =
-                            parent_width - css_right.calc_percent(parent_width) -
-                            el->position_.width - el->content_margin_right();
-                    } else {
-                        el->position_.x = css_left.calc_percent(parent_width) +
-                                      el->content_margin_left();
-                        el->position_.width = parent_width -
-                                          css_left.calc_percent(parent_width) -
-                                          css_right.calc_percent(parent_width) -
-                                          (el->content_margin_left() +
-                                              el->content_margin_right());
-                        need_render = true;
-                    }
-                }
-
-                if (!css_top.is_predefined() || !css_bottom.is_predefined()) {
-                    if (!css_top.is_predefined() && css_bottom.is_predefined()) {
-                        el->position_.y = css_top.calc_percent(parent_height) +
-                                      el->content_margin_top();
-                    } else if (css_top.is_predefined() &&
-                               !css_bottom.is_predefined()) {
-                        el->position_.y = parent_height -
-                                      css_bottom.calc_percent(parent_height) -
-                                      el->position_.height -
-                                      el->content_margin_bottom();
-                    } else {
-                        el->position_.y = css_top.calc_percent(parent_height) +
-                                      el->content_margin_top();
-                        el->position_.height =
-                            parent_height - css_top.calc_percent(parent_height) -
-                            css_bottom.calc_percent(parent_height) -
-                            (el->content_margin_top() +
-                                el->content_margin_bottom());
-                        need_render = true;
-                    }
+            if (!css_top.is_predefined() || !css_bottom.is_predefined()) {
+                if (!css_top.is_predefined() && css_bottom.is_predefined()) {
+                    el->position_.y = css_top.calc_percent(parent_height) +
+                                  el->content_margin_top();
+                } else if (css_top.is_predefined() &&
+                           !css_bottom.is_predefined()) {
+                    el->position_.y = parent_height -
+                                  css_bottom.calc_percent(parent_height) -
+                                  el->position_.height -
+                                  el->content_margin_bottom();
+                } else {
+                    el->position_.y = css_top.calc_percent(parent_height) +
+                                  el->content_margin_top();
+                    el->position_.height =
+                        parent_height - css_top.calc_percent(parent_height) -
+                        css_bottom.calc_percent(parent_height) -
+                        (el->content_margin_top() +
+                            el->content_margin_bottom());
+                    need_render = true;
                 }
-            } else {
-                if (!css_left.is_predefined() || !css_right.is_predefined()) {
-                    if (!css_left.is_predefined() && css_right.is_predefined()) {
-                        el->position_.x = css_left.calc_percent(parent_width) +
-                                      el->content_margin_left() - padding_.left;
-                    } else if (css_left.is_predefined() &&
-                               !css_right.is_predefined()) {
-                        el->position_.x = position_.width + padding_.right -
+            }
+        } else {
+            if (!css_left.is_predefined() || !css_right.is_predefined()) {
+                if (!css_left.is_predefined() && css_right.is_predefined()) {
+                    el->position_.x = css_left.calc_percent(parent_width) +
+                                  el->content_margin_left() - padding_.left;
+                } else if (css_left.is_predefined() &&
+                           !css_right.is_predefined()) {
+                    el->position_.x = position_.width + padding_.right -
+                                  css_right.calc_percent(parent_width) -
+                                  el->position_.width -
+                                  el->content_margin_right();
+                } else {
+                    el->position_.x = css_left.calc_percent(parent_width) +
+                                  el->content_margin_left() - padding_.left;
+                    el->position_.width = position_.width + padding_.left +
+                                      padding_.right -
+                                      css_left.calc_percent(parent_width) -
                                       css_right.calc_percent(parent_width) -
-                                      el->position_.width -
-                                      el->content_margin_right();
-                    } else {
-                        el->position_.x = css_left.calc_percent(parent_width) +
-                                      el->content_margin_left() - padding_.left;
-                        el->position_.width = position_.width + padding_.left +
-                                          padding_.right -
-                                          css_left.calc_percent(parent_width) -
-                                          css_right.calc_percent(parent_width) -
-                                          (el->content_margin_left() +
-                                              el->content_margin_right());
-                        if (new_width != -1) {
-                            el->position_.x += (el->position_.width - new_width) / 2;
-                            el->position_.width = new_width;
-                        }
-                        need_render = true;
+                                      (el->content_margin_left() +
+                                          el->content_margin_right());
+                    if (new_width != -1) {
+                        el->position_.x += (el->position_.width - new_width) / 2;
+                        el->position_.width = new_width;
                     }
-                    cvt_x = true;
-                }
-
-                if (!css_top.is_predefined() || !css_bottom.is_predefined()) {
-                    if (!css_top.is_predefined() && css_bottom.is_predefined()) {
-                        el->position_.y = css_top.calc_percent(parent_height) +
-                                      el->content_margin_top() - padding_.top;
-                    } else if (css_top.is_predefined() &&
-                               !css_bottom.is_predefined()) {
-                        el->position_.y = position_.height + padding_.bottom -
-                                      css_bottom.calc_percent(parent_height) -
-                                      el->position_.height -
-                                      el->content_margin_bottom();
-                    } else {
-                        el->position_.y = css_top.calc_percent(parent_height) +
-                                      el->content_margin_top() - padding_.top;
-                        el->position_.height =
-                            position_.height + padding_.top + padding_.bottom -
-                            css_top.calc_percent(parent_height) -
-                            css_bottom.calc_percent(parent_height) -
-                            (el->content_margin_top() +
-                                el->content_margin_bottom());
-                        if (new_height != -1) {
-                            el->position_.y += (el->position_.height - new_height) / 2;
-                            el->position_.height = new_height;
-                        }
-                        need_render = true;
-                    }
-                    cvt_y = true;
+                    need_render = true;
                 }
+                cvt_x = true;
             }
 
-            if (cvt_x || cvt_y) {
-                int offset_x = 0;
-                int offset_y = 0;
-                Element::ptr cur_el = el->parent();
-                Element::ptr this_el = this;
-                while (cur_el && cur_el != this_el) {
-                    offset_x += cur_el->position_.x;
-                    offset_y += cur_el->position_.y;
-                    cur_el = cur_el->parent();
+            if (!css_top.is_predefined() || !css_bottom.is_predefined()) {
+                if (!css_top.is_predefined() && css_bottom.is_predefined()) {
+                    el->position_.y = css_top.calc_percent(parent_height) +
+                                  el->content_margin_top() - padding_.top;
+                } else if (css_top.is_predefined() &&
+                           !css_bottom.is_predefined()) {
+                    el->position_.y = position_.height + padding_.bottom -
+                                  css_bottom.calc_percent(parent_height) -
+                                  el->position_.height -
+                                  el->content_margin_bottom();
+                } else {
+                    el->position_.y = css_top.calc_percent(parent_height) +
+                                  el->content_margin_top() - padding_.top;
+                    el->position_.height =
+                        position_.height + padding_.top + padding_.bottom -
+                        css_top.calc_percent(parent_height) -
+                        css_bottom.calc_percent(parent_height) -
+                        (el->content_margin_top() +
+                            el->content_margin_bottom());
+                    if (new_height != -1) {
+                        el->position_.y += (el->position_.height - new_height) / 2;
+                        el->position_.height = new_height;
+                    }
+                    need_render = true;
                 }
-                if (cvt_x)
-                    el->position_.x -= offset_x;
-                if (cvt_y)
-                    el->position_.y -= offset_y;
+                cvt_y = true;
             }
+        }
 
-            if (need_render) {
-                Position pos = el->position_;
-                el->render(el->left(), el->top(), el->width(), true);
-                el->position_ = pos;
+        if (cvt_x || cvt_y) {
+            int offset_x = 0;
+            int offset_y = 0;
+            Element::ptr cur_el = el->parent();
+            Element::ptr this_el = this;
+            while (cur_el && cur_el != this_el) {
+                offset_x += cur_el->position_.x;
+                offset_y += cur_el->position_.y;
+                cur_el = cur_el->parent();
             }
+            if (cvt_x)
+                el->position_.x -= offset_x;
+            if (cvt_y)
+                el->position_.y -= offset_y;
         }
 
-        el->render_positioned();
+        if (need_render) {
+            Position pos = el->position_;
+            el->render(el->left(), el->top(), el->width(), true);
+            el->position_ = pos;
+        }
     }
 
+    el->render_positioned();
+}
+
+void HTMLElement::render_positioned()
+{
+    Position wnd_position = get_document()->client_rect();
+
+    // The positioned elements are in separate subtrees, so they can be laid
+    // out independently of each other.
+    get_document()->layout_in_parallel(m_positioned.size(), [&](size_t i) {
+        render_positioned_element(m_positioned[i], wnd_position);
+    });
+
     if (!m_positioned.empty()) {
         std::stable_sort(m_positioned.begin(),
             m_positioned.end(),
@@ -3044,41 +3470,13 @@ void HTMLElement::draw_stacking_context(uintptr_t hdc,
     if (!is_visible())
         return;
 
-    std::map<int, bool> zindexes;
-    if (with_positioned) {
-        for (ElementsVector::iterator i = m_positioned.begin();
-             i != m_positioned.end();
-             i++) {
-            zindexes[(*i)->get_zindex()];
-        }
-
-        for (std::map<int, bool>::iterator idx = zindexes.begin();
-             idx != zindexes.end();
-             idx++) {
-            if (idx->first < 0) {
-                draw_children(hdc, x, y, clip, kDrawPositioned, idx->first);
-            }
-        }
-    }
-    draw_children(hdc, x, y, clip, kDrawBlock, 0);
-    draw_children(hdc, x, y, clip, kDrawFloats, 0);
-    draw_children(hdc, x, y, clip, kDrawInlines, 0);
-    if (with_positioned) {
-        for (std::map<int, bool>::iterator idx = zindexes.begin();
-             idx != zindexes.end();
-             idx++) {
-            if (idx->first == 0) {
-                draw_children(hdc, x, y, clip, kDrawPositioned, idx->first);
-            }
-        }
-
-        for (std::map<int, bool>::iterator idx = zindexes.begin();
-             idx != zindexes.end();
-             idx++) {
-            if (idx->first > 0) {
-                draw_children(hdc, x, y, clip, kDrawPositioned, idx->first);
-            }
-        }
+    const PaintOrder& order = paint_order(with_positioned);
+    if (clip && !order.bands.empty()) {
+        std::vector<int> indices;
+        find_paint_steps(order, clip->top() - y, clip->bottom() - y, indices);
+        draw_paint_steps(hdc, x, y, clip, order.steps, &indices);
+    } else {
+        draw_paint_steps(hdc, x, y, clip, order.steps);
     }
 }
 
@@ -3191,7 +3589,7 @@ void HTMLElement::calc_document_size(Size& sz, int x /*= 0*/, int y /*= 0*/)
 
         // root element (<html>) must to cover entire window
         if (!have_parent()) {
-            Position client_pos = get_document()->container()->get_client_rect();
+            Position client_pos = get_document()->client_rect();
             position_.height = std::max(sz.height, client_pos.height) -
                            content_margin_top() - content_margin_bottom();
             position_.width = std::max(sz.width, client_pos.width) -
@@ -3294,6 +3692,17 @@ bool HTMLElement::is_only_child(const Element::ptr& el, bool of_type) const
     return true;
 }
 
+void HTMLElement::rebuild_floats_index()
+{
+    floats_index_.clear();
+    for (const auto& fb : m_floats_left) {
+        floats_index_.add(fb);
+    }
+    for (const auto& fb : m_floats_right) {
+        floats_index_.add(fb);
+    }
+}
+
 void HTMLElement::update_floats(int dy, const Element::ptr& parent)
 {
     if (is_floats_holder()) {
@@ -3306,10 +3715,6 @@ void HTMLElement::update_floats(int dy, const Element::ptr& parent)
                 fb->pos.y += dy;
             }
         }
-        if (reset_cache) {
-            m_cahe_line_left.invalidate();
-        }
-        reset_cache = false;
         for (floated_box::vector::reverse_iterator fb = m_floats_right.rbegin();
              fb != m_floats_right.rend();
              fb++) {
@@ -3319,7 +3724,7 @@ void HTMLElement::update_floats(int dy, const Element::ptr& parent)
             }
         }
         if (reset_cache) {
-            m_cahe_line_right.invalidate();
+            rebuild_floats_index();
         }
     } else {
         Element::ptr el_parent = this->parent();
@@ -3400,7 +3805,7 @@ void HTMLElement::refresh_styles()
     for (auto& usel : m_used_styles) {
         usel->m_used = false;
 
-        if (usel->m_selector->is_media_valid()) {
+        if (usel->m_selector->is_media_valid(get_document())) {
             int apply = select(*usel->m_selector, false);
 
             if (apply != select_no_match) {
@@ -3447,116 +3852,13 @@ Element::ptr HTMLElement::get_child_by_point(int x,
     DrawFlag flag,
     int zindex)
 {
-    Element::ptr ret = nullptr;
-
-    if (overflow_ > kOverflowVisible) {
-        if (!position_.is_point_inside(x, y)) {
-            return ret;
-        }
-    }
-
-    Position pos = position_;
-    pos.x = x - pos.x;
-    pos.y = y - pos.y;
-
-    for (ElementsVector::reverse_iterator i = m_children.rbegin();
-         i != m_children.rend() && !ret;
-         i++) {
-        Element::ptr el = (*i);
-
-        if (el->is_visible() && el->get_display() != kDisplayInlineText) {
-            switch (flag) {
-                case kDrawPositioned:
-                    if (el->is_positioned() && el->get_zindex() == zindex) {
-                        if (el->get_element_position() == kPositionFixed) {
-                            ret = el->get_element_by_point(client_x,
-                                client_y,
-                                client_x,
-                                client_y);
-                            if (!ret && (*i)->is_point_inside(client_x, client_y)) {
-                                ret = (*i);
-                            }
-                        } else {
-                            ret = el->get_element_by_point(pos.x,
-                                pos.y,
-                                client_x,
-                                client_y);
-                            if (!ret && (*i)->is_point_inside(pos.x, pos.y)) {
-                                ret = (*i);
-                            }
-                        }
-                        el = nullptr;
-                    }
-                    break;
-                case kDrawBlock:
-                    if (!el->is_inline_box() && el->get_float() == kFloatNone &&
-                        !el->is_positioned()) {
-                        if (el->is_point_inside(pos.x, pos.y)) {
-                            ret = el;
-                        }
-                    }
-                    break;
-                case kDrawFloats:
-                    if (el->get_float() != kFloatNone && !el->is_positioned()) {
-                        ret = el->get_element_by_point(pos.x, pos.y, client_x, client_y);
-
-                        if (!ret && (*i)->is_point_inside(pos.x, pos.y)) {
-                            ret = (*i);
-                        }
-                        el = nullptr;
-                    }
-                    break;
-                case kDrawInlines:
-                    if (el->is_inline_box() && el->get_float() == kFloatNone &&
-                        !el->is_positioned()) {
-                        if (el->get_display() == kDisplayInlineBlock) {
-                            ret = el->get_element_by_point(pos.x,
-                                pos.y,
-                                client_x,
-                                client_y);
-                            el = nullptr;
-                        }
-                        if (!ret && (*i)->is_point_inside(pos.x, pos.y)) {
-                            ret = (*i);
-                        }
-                    }
-                    break;
-                default:
-                    break;
-            }
-
-            if (el && !el->is_positioned()) {
-                if (flag == kDrawPositioned) {
-                    Element::ptr child = el->get_child_by_point(pos.x,
-                        pos.y,
-                        client_x,
-                        client_y,
-                        flag,
-                        zindex);
-                    if (child) {
-                        ret = child;
-                    }
-                } else {
-                    if (el->get_float() == kFloatNone &&
-                        el->get_display() != kDisplayInlineBlock) {
-                        Element::ptr child = el->get_child_by_point(pos.x,
-                            pos.y,
-                            client_x,
-                            client_y,
-                            flag,
-                            zindex);
-                        if (child) {
-                            ret = child;
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    return ret;
+    std::vector<PaintStep> steps;
+    add_paint_steps(steps, 0, 0, flag, zindex);
+    return get_paint_step_by_point(steps, nullptr, x, y, client_x, client_y);
 }
 
+// Returns the element drawn last at (x, y), the same way
+// draw_stacking_context() draws them.
 Element::ptr HTMLElement::get_element_by_point(int x, int y, int client_x, int client_y)
 {
     if (!is_visible()) {
@@ -3565,56 +3867,13 @@ Element::ptr HTMLElement::get_element_by_point(int x, int y, int client_x, int c
 
     Element* ret = nullptr;
 
-    std::map<int, bool> zindexes;
-
-    for (ElementsVector::iterator i = m_positioned.begin();
-         i != m_positioned.end();
-         i++) {
-        zindexes[(*i)->get_zindex()];
-    }
-
-    for (std::map<int, bool>::iterator idx = zindexes.begin();
-         idx != zindexes.end() && !ret;
-         idx++) {
-        if (idx->first > 0) {
-            ret =
-                get_child_by_point(x, y, client_x, client_y, kDrawPositioned, idx->first);
-        }
-    }
-    if (ret)
-        return ret;
-
-    for (std::map<int, bool>::iterator idx = zindexes.begin();
-         idx != zindexes.end() && !ret;
-         idx++) {
-        if (idx->first == 0) {
-            ret =
-                get_child_by_point(x, y, client_x, client_y, kDrawPositioned, idx->first);
-        }
-    }
-    if (ret)
-        return ret;
-
-    ret = get_child_by_point(x, y, client_x, client_y, kDrawInlines, 0);
-    if (ret)
-        return ret;
-
-    ret = get_child_by_point(x, y, client_x, client_y, kDrawFloats, 0);
-    if (ret)
-        return ret;
-
-    ret = get_child_by_point(x, y, client_x, client_y, kDrawBlock, 0);
-    if (ret)
-        return ret;
-
-
-    for (std::map<int, bool>::iterator idx = zindexes.begin();
-         idx != zindexes.end() && !ret;
-         idx++) {
-        if (idx->first < 0) {
-            ret =
-                get_child_by_point(x, y, client_x, client_y, kDrawPositioned, idx->first);
-        }
+    const PaintOrder& order = paint_order(true);
+    if (!order.bands.empty()) {
+        std::vector<int> indices;
+        find_paint_steps(order, y, y, indices);
+        ret = get_paint_step_by_point(order.steps, &indices, x, y, client_x, client_y);
+    } else {
+        ret = get_paint_step_by_point(order.steps, nullptr, x, y, client_x, client_y);
     }
     if (ret)
         return ret;
@@ -3710,11 +3969,27 @@ int HTMLElement::render_box(int x, int y, int max_width, bool second_pass /*= fa
         }
     }
 
+    // A shrink-to-fit element is laid out twice: first to find the width of
+    // its contents, then at that width (see below). Skip the first pass if
+    // it is known to find the same width as last time.
+    if (!second_pass) {
+        const ShrinkToFitCache& cache = shrink_to_fit_cache_;
+        if (!layout_dirty_ && cache.valid &&
+            cache.generation == get_document()->layout_generation() &&
+            max_width >= cache.min_width && max_width <= cache.max_width &&
+            is_shrink_to_fit()) {
+            render(x, y, cache.width, true);
+            position_.width =
+                cache.width - (content_margin_left() + content_margin_right());
+            return cache.width;
+        }
+        shrink_to_fit_cache_.valid = false;
+    }
+
     m_floats_left.clear();
     m_floats_right.clear();
     m_boxes.clear();
-    m_cahe_line_left.invalidate();
-    m_cahe_line_right.invalidate();
+    floats_index_.clear();
 
     ElementPosition el_position;
 
@@ -3767,6 +4042,8 @@ int HTMLElement::render_box(int x, int y, int max_width, bool second_pass /*= fa
 
     finish_last_box(true);
 
+    intrinsically_sized_ = calc_intrinsically_sized();
+
     if (block_width.is_default() && is_inline_box()) {
         position_.width = ret_width;
     } else {
@@ -3872,15 +4149,22 @@ int HTMLElement::render_box(int x, int y, int max_width, bool second_pass /*= fa
     ret_width += content_margin_left() + content_margin_right();
 
     // re-render with new width
-    if (ret_width < max_width && !second_pass && have_parent()) {
-        if (m_display == kDisplayInlineBlock ||
-            (m_css_width.is_predefined() &&
-                (m_float != kFloatNone || m_display == kDisplayTable ||
-                    m_el_position == kPositionAbsolute ||
-                    m_el_position == kPositionFixed))) {
-            render(x, y, ret_width, true);
-            position_.width =
-                ret_width - (content_margin_left() + content_margin_right());
+    if (ret_width < max_width && !second_pass && is_shrink_to_fit()) {
+        render(x, y, ret_width, true);
+        position_.width =
+            ret_width - (content_margin_left() + content_margin_right());
+
+        // Lines that fit in max_width also fit in any width down to
+        // ret_width + 1 (which still leaves room for the second pass), and
+        // lines that didn't fit still don't, so the first pass would find
+        // the same width for any of them.
+        if (intrinsically_sized_) {
+            shrink_to_fit_cache_.valid = true;
+            shrink_to_fit_cache_.generation =
+                get_document()->layout_generation();
+            shrink_to_fit_cache_.min_width = ret_width + 1;
+            shrink_to_fit_cache_.max_width = max_width;
+            shrink_to_fit_cache_.width = ret_width;
         }
     }
 
@@ -3894,6 +4178,49 @@ int HTMLElement::render_box(int x, int y, int max_width, bool second_pass /*= fa
     return ret_width;
 }
 
+void HTMLElement::layout_table_cells(
+    const std::function<void(int col, table_cell* cell)>& fn)
+{
+    // Table cells are floats holders, so they can be laid out independently
+    // of each other.
+    int cols_count = m_grid->cols_count();
+    get_document()->layout_in_parallel(
+        (size_t)cols_count * m_grid->rows_count(),
+        [&](size_t i) {
+            int col = (int)(i % cols_count);
+            table_cell* cell = m_grid->cell(col, (int)(i / cols_count));
+            if (cell && cell->el) {
+                fn(col, cell);
+            }
+        });
+}
+
+void HTMLElement::measure_table_cell(table_cell* cell, int available)
+{
+    Document* doc = get_document();
+
+    // The minimum content width only depends on the cell contents.
+    if (!cell->measured || cell->el->needs_layout() ||
+        cell->measured_generation != doc->layout_generation()) {
+        cell->min_width = cell->el->render(0, 0, 1);
+        cell->measured = false;
+    }
+
+    // An intrinsically sized cell lays out the same way at any width from
+    // its maximum content width + 1 up to the width it was measured at (see
+    // render_box()), so the maximum content width doesn't change either.
+    if (!cell->measured || (available != cell->measured_available &&
+                               !(cell->el->is_intrinsically_sized() &&
+                                   available > cell->max_width &&
+                                   available < cell->measured_available))) {
+        cell->max_width = cell->el->render(0, 0, available);
+        cell->measured_available = available;
+    }
+
+    cell->measured = true;
+    cell->measured_generation = doc->layout_generation();
+}
+
 int HTMLElement::render_table(int x, int y, int max_width, bool /* second_pass *//*= false*/)
 {
     if (!m_grid)
@@ -3948,43 +4275,46 @@ int HTMLElement::render_table(int x, int y, int max_width, bool /* second_pass *
     //
     // Also, calculate the "maximum" cell width of each cell: formatting the content
     // without breaking lines other than where explicit line breaks occur.
+    //
+    // With 'table-layout: fixed' the column widths don't depend on the cell
+    // contents (see table_grid::calc_fixed_table_width()), so the cells are
+    // only rendered once, at their final width.
 
-    if (m_grid->cols_count() == 1 && !block_width.is_default()) {
-        for (int row = 0; row < m_grid->rows_count(); row++) {
-            table_cell* cell = m_grid->cell(0, row);
-            if (cell && cell->el) {
-                cell->min_width = cell->max_width =
-                    cell->el->render(0, 0, max_width - table_width_spacing);
-                cell->el->position_.width = cell->min_width -
-                                        cell->el->content_margin_left() -
-                                        cell->el->content_margin_right();
-            }
-        }
-    } else {
+    bool fixed_layout =
+        table_layout_ == kTableLayoutFixed && !block_width.is_default();
+
+    if (fixed_layout) {
         for (int row = 0; row < m_grid->rows_count(); row++) {
             for (int col = 0; col < m_grid->cols_count(); col++) {
                 table_cell* cell = m_grid->cell(col, row);
-                if (cell && cell->el) {
-                    if (!m_grid->column(col).css_width.is_predefined() &&
-                        m_grid->column(col).css_width.units() !=
-                            kCSSUnitsPercent) {
-                        int css_w = m_grid->column(col).css_width.calc_percent(
-                            block_width);
-                        int el_w = cell->el->render(0, 0, css_w);
-                        cell->min_width = cell->max_width = std::max(css_w, el_w);
-                        cell->el->position_.width =
-                            cell->min_width - cell->el->content_margin_left() -
-                            cell->el->content_margin_right();
-                    } else {
-                        // calculate minimum content width
-                        cell->min_width = cell->el->render(0, 0, 1);
-                        // calculate maximum content width
-                        cell->max_width =
-                            cell->el->render(0, 0, max_width - table_width_spacing);
-                    }
-                }
+                cell->min_width = cell->max_width = 0;
+                cell->measured = false;
             }
         }
+    } else if (m_grid->cols_count() == 1 && !block_width.is_default()) {
+        layout_table_cells([&](int /* col */, table_cell* cell) {
+            cell->min_width = cell->max_width =
+                cell->el->render(0, 0, max_width - table_width_spacing);
+            cell->el->position_.width = cell->min_width -
+                                    cell->el->content_margin_left() -
+                                    cell->el->content_margin_right();
+            cell->measured = false;
+        });
+    } else {
+        layout_table_cells([&](int col, table_cell* cell) {
+            if (!m_grid->column(col).css_width.is_predefined() &&
+                m_grid->column(col).css_width.units() != kCSSUnitsPercent) {
+                int css_w = m_grid->column(col).css_width.calc_percent(block_width);
+                int el_w = cell->el->render(0, 0, css_w);
+                cell->min_width = cell->max_width = std::max(css_w, el_w);
+                cell->el->position_.width = cell->min_width -
+                                        cell->el->content_margin_left() -
+                                        cell->el->content_margin_right();
+                cell->measured = false;
+            } else {
+                measure_table_cell(cell, max_width - table_width_spacing);
+            }
+        });
     }
 
     // For each column, determine a maximum and minimum column width from the
@@ -4057,7 +4387,10 @@ int HTMLElement::render_table(int x, int y, int max_width, bool /* second_pass *
     int min_table_width = 0;
     int max_table_width = 0;
 
-    if (!block_width.is_default()) {
+    if (fixed_layout) {
+        table_width = min_table_width = max_table_width =
+            m_grid->calc_fixed_table_width(block_width - table_width_spacing);
+    } else if (!block_width.is_default()) {
         table_width = m_grid->calc_table_width(block_width - table_width_spacing,
             false,
             min_table_width,
@@ -4076,33 +4409,39 @@ int HTMLElement::render_table(int x, int y, int max_width, bool /* second_pass *
         m_border_collapse,
         m_border_spacing_x);
 
+    // render cells with computed width
+    layout_table_cells([&](int col, table_cell* cell) {
+        int span_col = col + cell->colspan - 1;
+        if (span_col >= m_grid->cols_count()) {
+            span_col = m_grid->cols_count() - 1;
+        }
+        int cell_width = m_grid->column(span_col).right - m_grid->column(col).left;
+
+        // Cells with a fixed layout haven't been rendered yet, and the cells
+        // measured by measure_table_cell() may have kept an older layout, so
+        // render those anyway (which is free if the cell was last rendered at
+        // cell_width).
+        if (fixed_layout || cell->measured ||
+            cell->el->position_.width != cell_width -
+                                             cell->el->content_margin_left() -
+                                             cell->el->content_margin_right()) {
+            cell->el->render(m_grid->column(col).left, 0, cell_width);
+            cell->el->position_.width = cell_width -
+                                    cell->el->content_margin_left() -
+                                    cell->el->content_margin_right();
+        } else {
+            cell->el->position_.x =
+                m_grid->column(col).left + cell->el->content_margin_left();
+        }
+    });
+
     bool row_span_found = false;
 
-    // render cells with computed width
     for (int row = 0; row < m_grid->rows_count(); row++) {
         m_grid->row(row).height = 0;
         for (int col = 0; col < m_grid->cols_count(); col++) {
             table_cell* cell = m_grid->cell(col, row);
             if (cell->el) {
-                int span_col = col + cell->colspan - 1;
-                if (span_col >= m_grid->cols_count()) {
-                    span_col = m_grid->cols_count() - 1;
-                }
-                int cell_width =
-                    m_grid->column(span_col).right - m_grid->column(col).left;
-
-                if (cell->el->position_.width !=
-                    cell_width - cell->el->content_margin_left() -
-                        cell->el->content_margin_right()) {
-                    cell->el->render(m_grid->column(col).left, 0, cell_width);
-                    cell->el->position_.width = cell_width -
-                                            cell->el->content_margin_left() -
-                                            cell->el->content_margin_right();
-                } else {
-                    cell->el->position_.x = m_grid->column(col).left +
-                                        cell->el->content_margin_left();
-                }
-
                 if (cell->rowspan <= 1) {
                     m_grid->row(row).height =
                         std::max(m_grid->row(row).height, cell->el->height());
@@ -4230,10 +4569,27 @@ int HTMLElement::render_table(int x, int y, int max_width, bool /* second_pass *
     return max_table_width;
 }
 
-void HTMLElement::draw_children_box(uintptr_t hdc,
+void HTMLElement::set_overflow_clip(int x, int y)
+{
+    Position pos = position_;
+    pos.x += x;
+    pos.y += y;
+
+    Position border_box = pos;
+    border_box += padding_;
+    border_box += border_;
+
+    BorderRadii border_radii = m_css_borders.radii.calculate_radii(border_box.width, border_box.height);
+
+    border_radii -= border_;
+    border_radii -= padding_;
+
+    get_document()->container()->set_clip(pos, border_radii, true, true);
+}
+
+void HTMLElement::add_paint_steps_box(std::vector<PaintStep>& steps,
     int x,
     int y,
-    const Position* clip,
     DrawFlag flag,
     int zindex)
 {
@@ -4241,23 +4597,20 @@ void HTMLElement::draw_children_box(uintptr_t hdc,
     pos.x += x;
     pos.y += y;
 
-    Document* doc = get_document();
-
+    size_t first_step = steps.size();
     if (overflow_ > kOverflowVisible) {
-        Position border_box = pos;
-        border_box += padding_;
-        border_box += border_;
-
-        BorderRadii border_radii = m_css_borders.radii.calculate_radii(border_box.width, border_box.height);
-
-        border_radii -= border_;
-        border_radii -= padding_;
-
-        doc->container()->set_clip(pos, border_radii, true, true);
+        PaintStep clip_step;
+        clip_step.type = PaintStep::kSetClip;
+        clip_step.element = this;
+        clip_step.x = x;
+        clip_step.y = y;
+        clip_step.fixed = false;
+        clip_step.with_positioned = false;
+        clip_step.bounded = true;
+        steps.push_back(clip_step);
+        first_step = steps.size();
     }
 
-    Position browser_wnd = doc->container()->get_client_rect();
-
     Element::ptr el;
     for (auto& item : m_children) {
         el = item;
@@ -4265,40 +4618,44 @@ void HTMLElement::draw_children_box(uintptr_t hdc,
             switch (flag) {
                 case kDrawPositioned:
                     if (el->is_positioned() && el->get_zindex() == zindex) {
-                        if (el->get_element_position() == kPositionFixed) {
-                            el->draw(hdc, browser_wnd.x, browser_wnd.y, clip);
-                            el->draw_stacking_context(hdc,
-                                browser_wnd.x,
-                                browser_wnd.y,
-                                clip,
-                                true);
-                        } else {
-                            el->draw(hdc, pos.x, pos.y, clip);
-                            el->draw_stacking_context(hdc, pos.x, pos.y, clip, true);
-                        }
+                        add_paint_step(steps,
+                            PaintStep::kDrawStackingContext,
+                            el,
+                            pos.x,
+                            pos.y,
+                            el->get_element_position() == kPositionFixed,
+                            true);
                         el = nullptr;
                     }
                     break;
                 case kDrawBlock:
                     if (!el->is_inline_box() && el->get_float() == kFloatNone &&
                         !el->is_positioned()) {
-                        el->draw(hdc, pos.x, pos.y, clip);
+                        add_paint_step(steps, PaintStep::kDraw, el, pos.x, pos.y);
                     }
                     break;
                 case kDrawFloats:
                     if (el->get_float() != kFloatNone && !el->is_positioned()) {
-                        el->draw(hdc, pos.x, pos.y, clip);
-                        el->draw_stacking_context(hdc, pos.x, pos.y, clip, false);
+                        add_paint_step(steps,
+                            PaintStep::kDrawStackingContext,
+                            el,
+                            pos.x,
+                            pos.y);
                         el = nullptr;
                     }
                     break;
                 case kDrawInlines:
                     if (el->is_inline_box() && el->get_float() == kFloatNone &&
                         !el->is_positioned()) {
-                        el->draw(hdc, pos.x, pos.y, clip);
                         if (el->get_display() == kDisplayInlineBlock) {
-                            el->draw_stacking_context(hdc, pos.x, pos.y, clip, false);
+                            add_paint_step(steps,
+                                PaintStep::kDrawStackingContext,
+                                el,
+                                pos.x,
+                                pos.y);
                             el = nullptr;
+                        } else {
+                            add_paint_step(steps, PaintStep::kDraw, el, pos.x, pos.y);
                         }
                     }
                     break;
@@ -4309,13 +4666,13 @@ void HTMLElement::draw_children_box(uintptr_t hdc,
             if (el) {
                 if (flag == kDrawPositioned) {
                     if (!el->is_positioned()) {
-                        el->draw_children(hdc, pos.x, pos.y, clip, flag, zindex);
+                        el->add_paint_steps(steps, pos.x, pos.y, flag, zindex);
                     }
                 } else {
                     if (el->get_float() == kFloatNone &&
                         el->get_display() != kDisplayInlineBlock &&
                         !el->is_positioned()) {
-                        el->draw_children(hdc, pos.x, pos.y, clip, flag, zindex);
+                        el->add_paint_steps(steps, pos.x, pos.y, flag, zindex);
                     }
                 }
             }
@@ -4323,14 +4680,33 @@ void HTMLElement::draw_children_box(uintptr_t hdc,
     }
 
     if (overflow_ > kOverflowVisible) {
-        doc->container()->del_clip();
+        // Don't clip if nothing is drawn in this pass.
+        if (steps.size() == first_step) {
+            steps.pop_back();
+            return;
+        }
+
+        // The clip is needed wherever the steps in it draw.
+        PaintStep& clip_step = steps[first_step - 1];
+        for (size_t i = first_step; i < steps.size(); i++) {
+            if (!steps[i].bounded) {
+                clip_step.bounded = false;
+            } else if (i == first_step) {
+                clip_step.bounds = steps[i].bounds;
+            } else {
+                clip_step.bounds.unite(steps[i].bounds);
+            }
+        }
+
+        PaintStep unclip_step = clip_step;
+        unclip_step.type = PaintStep::kDelClip;
+        steps.push_back(unclip_step);
     }
 }
 
-void HTMLElement::draw_children_table(uintptr_t hdc,
+void HTMLElement::add_paint_steps_table(std::vector<PaintStep>& steps,
     int x,
     int y,
-    const Position* clip,
     DrawFlag flag,
     int zindex)
 {
@@ -4342,15 +4718,19 @@ void HTMLElement::draw_children_table(uintptr_t hdc,
     pos.y += y;
     for (int row = 0; row < m_grid->rows_count(); row++) {
         if (flag == kDrawBlock) {
-            m_grid->row(row).el_row->draw_background(hdc, pos.x, pos.y, clip);
+            add_paint_step(steps,
+                PaintStep::kDrawBackground,
+                m_grid->row(row).el_row,
+                pos.x,
+                pos.y);
         }
         for (int col = 0; col < m_grid->cols_count(); col++) {
             table_cell* cell = m_grid->cell(col, row);
             if (cell->el) {
                 if (flag == kDrawBlock) {
-                    cell->el->draw(hdc, pos.x, pos.y, clip);
+                    add_paint_step(steps, PaintStep::kDraw, cell->el, pos.x, pos.y);
                 }
-                cell->el->draw_children(hdc, pos.x, pos.y, clip, flag, zindex);
+                cell->el->add_paint_steps(steps, pos.x, pos.y, flag, zindex);
             }
         }
     }
@@ -45,6 +45,11 @@ ImageElement::~ImageElement(void)
 {
 }
 
+Element* ImageElement::clone(Document* document) const
+{
+    return clone_children(new ImageElement(*this), document);
+}
+
 Size ImageElement::get_content_size(int)
 {
     return get_document()->container()->get_image_size(src_);
@@ -77,6 +82,8 @@ bool ImageElement::is_replaced() const
 
 int ImageElement::render(int x, int y, int parent_width, bool /* second_pass */)
 {
+    layout_dirty_ = false;
+
     calc_outlines(parent_width);
 
     position_.move_to(x, y);
@@ -43,6 +43,11 @@ LiElement::~LiElement()
 {
 }
 
+Element* LiElement::clone(Document* document) const
+{
+    return clone_children(new LiElement(*this), document);
+}
+
 int LiElement::render(int x, int y, int max_width, bool second_pass)
 {
     if (list_style_type_ >= kListStyleTypeArmenian && !m_index_initialized) {
@@ -44,6 +44,11 @@ LinkElement::~LinkElement()
 {
 }
 
+Element* LinkElement::clone(Document* document) const
+{
+    return clone_children(new LinkElement(*this), document);
+}
+
 void LinkElement::parse_attributes()
 {
     bool processed = false;
@@ -43,6 +43,11 @@ ParagraphElement::~ParagraphElement()
 {
 }
 
+Element* ParagraphElement::clone(Document* document) const
+{
+    return clone_children(new ParagraphElement(*this), document);
+}
+
 void ParagraphElement::parse_attributes()
 {
     const char* str = get_attr("align");
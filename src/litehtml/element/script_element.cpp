@@ -44,6 +44,11 @@ ScriptElement::~ScriptElement()
 {
 }
 
+Element* ScriptElement::clone(Document* document) const
+{
+    return clone_children(new ScriptElement(*this), document);
+}
+
 void ScriptElement::set_attr(const char* name, const char* val)
 {
     if (name && val) {
@@ -43,6 +43,26 @@ StyleElement::~StyleElement()
 {
 }
 
+Element* StyleElement::clone(Document* document) const
+{
+    return clone_children(new StyleElement(*this), document);
+}
+
+void StyleElement::set_attr(const char* name, const char* val)
+{
+    if (name && val && !t_strcasecmp(name, "media")) {
+        media_ = val;
+    }
+}
+
+const char* StyleElement::get_attr(const char* name, const char* def) const
+{
+    if (name && !t_strcasecmp(name, "media") && !media_.empty()) {
+        return media_.c_str();
+    }
+    return def;
+}
+
 void StyleElement::parse_attributes()
 {
     std::string text;
@@ -70,6 +90,9 @@ std::string StyleElement::outer_html() const
     for (auto child : m_children) {
         child->get_text(inner);
     }
+    if (!media_.empty()) {
+        return "<style media=\"" + media_ + "\">" + inner + "</style>";
+    }
     return "<style>" + inner + "</style>";
 }
 
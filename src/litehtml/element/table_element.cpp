@@ -51,6 +51,11 @@ TableElement::~TableElement()
 {
 }
 
+Element* TableElement::clone(Document* document) const
+{
+    return clone_children(new TableElement(*this), document);
+}
+
 bool TableElement::append_child(Element* element)
 {
     if (!element)
@@ -72,6 +77,8 @@ void TableElement::parse_styles(bool is_reparse)
         BORDER_COLLAPSE_STRINGS,
         border_collapse_separate);
 
+    table_layout_ = get_keyword<TableLayout>(kCSSPropertyTableLayout);
+
     if (m_border_collapse == border_collapse_separate) {
         m_css_border_spacing_x.parse_length_string(
             get_style_property(kCSSPropertyLitehtmlBorderSpacingX));
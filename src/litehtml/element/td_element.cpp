@@ -43,6 +43,11 @@ TdElement::~TdElement()
 {
 }
 
+Element* TdElement::clone(Document* document) const
+{
+    return clone_children(new TdElement(*this), document);
+}
+
 void TdElement::parse_attributes()
 {
     const char* str = get_attr("width");
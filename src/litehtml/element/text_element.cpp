@@ -63,6 +63,11 @@ TextElement::~TextElement()
 {
 }
 
+Element* TextElement::clone(Document* document) const
+{
+    return clone_children(new TextElement(*this), document);
+}
+
 Size TextElement::get_content_size(int /* max_width */)
 {
     return size_;
@@ -133,13 +138,31 @@ void TextElement::parse_styles(bool /* is_reparse */)
         size_.width = 0;
     } else {
         size_.height = fm.height;
-        size_.width = get_document()->container()->text_width(
-            use_transformed_ ? transformed_text_.c_str() : text_.c_str(),
-            font);
+        if (!get_document()->measure_text_later(this)) {
+            size_.width = get_document()->text_width(measured_text(), font);
+        }
     }
     draw_spaces_ = fm.draw_spaces;
 }
 
+void TextElement::measure(Document* document,
+    const std::vector<TextElement*>& elements)
+{
+    std::vector<TextRun> runs(elements.size());
+    for (size_t i = 0; i < elements.size(); i++) {
+        Element::ptr el_parent = elements[i]->parent();
+        runs[i].text = elements[i]->measured_text();
+        runs[i].font = el_parent ? el_parent->get_font() : 0;
+    }
+
+    std::vector<int> widths(elements.size());
+    document->measure_texts(runs.data(), runs.size(), widths.data());
+
+    for (size_t i = 0; i < elements.size(); i++) {
+        elements[i]->size_.width = widths[i];
+    }
+}
+
 int TextElement::get_baseline()
 {
     Element::ptr el_parent = parent();
@@ -199,6 +222,11 @@ Display TextElement::get_display() const
     return kDisplayInlineText;
 }
 
+bool TextElement::is_intrinsically_sized() const
+{
+    return true;
+}
+
 WhiteSpace TextElement::get_white_space() const
 {
     Element::ptr el_parent = parent();
@@ -44,6 +44,11 @@ TitleElement::~TitleElement()
 {
 }
 
+Element* TitleElement::clone(Document* document) const
+{
+    return clone_children(new TitleElement(*this), document);
+}
+
 void TitleElement::parse_attributes()
 {
     std::string text;
@@ -43,6 +43,11 @@ TrElement::~TrElement()
 {
 }
 
+Element* TrElement::clone(Document* document) const
+{
+    return clone_children(new TrElement(*this), document);
+}
+
 void TrElement::parse_attributes()
 {
     const char* str = get_attr("align");
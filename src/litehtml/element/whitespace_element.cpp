@@ -53,6 +53,11 @@ WhitespaceElement::~WhitespaceElement()
 {
 }
 
+Element* WhitespaceElement::clone(Document* document) const
+{
+    return clone_children(new WhitespaceElement(*this), document);
+}
+
 bool WhitespaceElement::is_whitespace() const
 {
     WhiteSpace ws = get_white_space();
@@ -0,0 +1,140 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "litehtml/float_index.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace litehtml {
+
+namespace {
+
+const int kNoRightFloat = INT_MAX;
+
+// Returns the value of the step function at y.
+int value_at(const std::map<int, int>& steps, int y, int def)
+{
+    auto step = steps.upper_bound(y);
+    if (step == steps.begin()) {
+        return def;
+    }
+    return std::prev(step)->second;
+}
+
+// Adds an entry to the step function at y (if there isn't one already)
+// without changing its value anywhere.
+void split(std::map<int, int>& steps, int y, int def)
+{
+    auto step = steps.lower_bound(y);
+    if (step != steps.end() && step->first == y) {
+        return;
+    }
+    int value = step == steps.begin() ? def : std::prev(step)->second;
+    steps.emplace_hint(step, y, value);
+}
+
+} // namespace
+
+void FloatIndex::clear()
+{
+    left_.clear();
+    right_.clear();
+    left_bottom_ = 0;
+    right_bottom_ = 0;
+}
+
+void FloatIndex::add(const floated_box& fb)
+{
+    int top = fb.pos.top();
+    int bottom = fb.pos.bottom();
+
+    if (fb.float_side == kFloatLeft) {
+        split(left_, top, 0);
+        split(left_, bottom, 0);
+        for (auto step = left_.find(top); step->first < bottom; step++) {
+            step->second = std::max(step->second, fb.pos.right());
+        }
+        left_bottom_ = std::max(left_bottom_, bottom);
+    } else if (fb.float_side == kFloatRight) {
+        split(right_, top, kNoRightFloat);
+        split(right_, bottom, kNoRightFloat);
+        for (auto step = right_.find(top); step->first < bottom; step++) {
+            step->second = std::min(step->second, fb.pos.left());
+        }
+        right_bottom_ = std::max(right_bottom_, bottom);
+    }
+}
+
+int FloatIndex::line_left(int y) const
+{
+    return value_at(left_, y, 0);
+}
+
+int FloatIndex::line_right(int y, int def_right) const
+{
+    return std::min(value_at(right_, y, kNoRightFloat), def_right);
+}
+
+int FloatIndex::find_next_line_top(int top, int width, int def_right) const
+{
+    // The width of the line only changes at the top or bottom of a float, so
+    // those are the only positions to check. Walk the steps of both maps
+    // from top in order, keeping track of their values.
+    auto left = left_.lower_bound(top);
+    auto right = right_.lower_bound(top);
+    int left_value = left == left_.begin() ? 0 : std::prev(left)->second;
+    int right_value =
+        right == right_.begin() ? kNoRightFloat : std::prev(right)->second;
+
+    int new_top = top;
+    while (left != left_.end() || right != right_.end()) {
+        if (right == right_.end() ||
+            (left != left_.end() && left->first <= right->first)) {
+            new_top = left->first;
+        } else {
+            new_top = right->first;
+        }
+        if (left != left_.end() && left->first == new_top) {
+            left_value = left->second;
+            left++;
+        }
+        if (right != right_.end() && right->first == new_top) {
+            right_value = right->second;
+            right++;
+        }
+
+        if (std::min(right_value, def_right) - left_value >= width) {
+            break;
+        }
+    }
+    return new_top;
+}
+
+} // namespace litehtml
@@ -0,0 +1,109 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the names of the copyright holders nor the names of their
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "litehtml/float_index.h"
+
+#include <gtest/gtest.h>
+
+using namespace litehtml;
+
+namespace {
+
+floated_box make_float(ElementFloat side, int x, int y, int width, int height)
+{
+  floated_box fb;
+  fb.pos = Position(x, y, width, height);
+  fb.float_side = side;
+  fb.clear_floats = kClearNone;
+  fb.el = nullptr;
+  return fb;
+}
+
+} // namespace
+
+TEST(FloatIndexTest, Empty)
+{
+  FloatIndex index;
+  EXPECT_EQ(0, index.line_left(0));
+  EXPECT_EQ(500, index.line_right(0, 500));
+  EXPECT_EQ(10, index.find_next_line_top(10, 100, 500));
+  EXPECT_EQ(0, index.left_height());
+  EXPECT_EQ(0, index.right_height());
+}
+
+TEST(FloatIndexTest, Line)
+{
+  FloatIndex index;
+  index.add(make_float(kFloatLeft, 0, 0, 100, 50));
+  index.add(make_float(kFloatLeft, 100, 20, 50, 10));
+  index.add(make_float(kFloatRight, 400, 40, 100, 40));
+
+  EXPECT_EQ(100, index.line_left(0));
+  EXPECT_EQ(150, index.line_left(20));
+  EXPECT_EQ(150, index.line_left(29));
+  EXPECT_EQ(100, index.line_left(30));
+  EXPECT_EQ(0, index.line_left(50));
+
+  EXPECT_EQ(500, index.line_right(39, 500));
+  EXPECT_EQ(400, index.line_right(40, 500));
+  EXPECT_EQ(300, index.line_right(40, 300));
+  EXPECT_EQ(500, index.line_right(80, 500));
+
+  EXPECT_EQ(50, index.left_height());
+  EXPECT_EQ(80, index.right_height());
+}
+
+TEST(FloatIndexTest, FindNextLineTop)
+{
+  FloatIndex index;
+  index.add(make_float(kFloatLeft, 0, 0, 200, 50));
+  index.add(make_float(kFloatRight, 300, 30, 200, 50));
+
+  // Lines narrower than the gap fit next to the floats.
+  EXPECT_EQ(0, index.find_next_line_top(0, 300, 500));
+
+  // Wider lines move down until the floats end.
+  EXPECT_EQ(80, index.find_next_line_top(0, 400, 500));
+  EXPECT_EQ(50, index.find_next_line_top(10, 300, 500));
+
+  // A line that never fits ends up below the last float.
+  EXPECT_EQ(80, index.find_next_line_top(0, 600, 500));
+
+  // Below every float the top is unchanged.
+  EXPECT_EQ(90, index.find_next_line_top(90, 600, 500));
+}
+
+TEST(FloatIndexTest, Clear)
+{
+  FloatIndex index;
+  index.add(make_float(kFloatLeft, 0, 0, 100, 50));
+  index.clear();
+  EXPECT_EQ(0, index.line_left(0));
+  EXPECT_EQ(0, index.left_height());
+}
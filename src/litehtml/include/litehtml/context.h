@@ -34,6 +34,11 @@
 
 namespace litehtml {
 
+// A Context holds the state shared between documents (currently the master
+// stylesheet). A Context is immutable once constructed, so one Context can
+// be shared by documents that are parsed and rendered concurrently on
+// different threads. Per-document state (e.g., which media queries match)
+// lives in the Document.
 class Context {
     CSSStylesheet master_stylesheet_;
 
@@ -42,9 +47,11 @@ public:
 
     explicit Context(const std::string& css);
 
-    void load_master_stylesheet(const std::string& css);
+    Context(const Context&) = delete;
 
-    CSSStylesheet& master_stylesheet()
+    Context& operator=(const Context&) = delete;
+
+    const CSSStylesheet& master_stylesheet() const
     {
         return master_stylesheet_;
     }
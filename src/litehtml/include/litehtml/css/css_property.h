@@ -130,6 +130,7 @@ enum CSSProperty : int {
     kCSSPropertyPaddingTop,
     kCSSPropertyPosition,
     kCSSPropertyRight,
+    kCSSPropertyTableLayout,
     kCSSPropertyTextAlign,
     kCSSPropertyTextDecoration,
     kCSSPropertyTextIndent,
@@ -259,7 +259,7 @@ public:
 
     bool parse(const std::string& text);
     void calc_specificity();
-    bool is_media_valid() const;
+    bool is_media_valid(const Document* doc) const;
     void add_media_to_doc(Document* doc) const;
 
 #if defined(ENABLE_JSON)
@@ -267,14 +267,6 @@ public:
 #endif
 };
 
-inline bool CSSSelector::is_media_valid() const
-{
-    if (!media_query_list_) {
-        return true;
-    }
-    return media_query_list_->is_used();
-}
-
 
 //////////////////////////////////////////////////////////////////////////
 
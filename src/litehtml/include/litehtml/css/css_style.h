@@ -61,6 +61,8 @@ private:
 public:
     CSSStyle();
 
+    CSSStyle(const CSSStyle& style);
+
     virtual ~CSSStyle();
 
     void add(const std::string& txt, const URL& baseurl)
@@ -119,6 +119,9 @@ public:
 
     static CSSValue* factory(CSSProperty property, const std::string& value, bool important);
 
+    // Returns a copy of the value (including the derived value type).
+    CSSValue* clone() const;
+
 #if defined(ENABLE_JSON)
     nlohmann::json json() const;
 #endif
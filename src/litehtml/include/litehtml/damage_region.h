@@ -0,0 +1,82 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LITEHTML_DAMAGE_REGION_H__
+#define LITEHTML_DAMAGE_REGION_H__
+
+#include <vector>
+
+#include "litehtml/types.h"
+
+namespace litehtml {
+
+// The area of a document that has to be drawn again, as a few rectangles
+// that don't overlap. Rectangles that overlap are merged as they are added,
+// and so are rectangles that are next to each other when their union wastes
+// no area, so drawing the region draws each pixel at most once.
+class DamageRegion {
+public:
+    // The most rectangles a region holds. Past it, the two rectangles whose
+    // union adds the least area are merged.
+    static constexpr size_t kMaxRects = 16;
+
+private:
+    std::vector<Position> rects_;
+
+    void insert(Position rect);
+
+public:
+    void add(const Position& rect);
+
+    void clear()
+    {
+        rects_.clear();
+    }
+
+    bool empty() const
+    {
+        return rects_.empty();
+    }
+
+    const std::vector<Position>& rects() const
+    {
+        return rects_;
+    }
+
+    // Returns the smallest rectangle that covers the region.
+    Position bounds() const;
+
+    // Returns the number of pixels in the region.
+    long long area() const;
+};
+
+} // namespace litehtml
+
+#endif // LITEHTML_DAMAGE_REGION_H__
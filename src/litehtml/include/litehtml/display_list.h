@@ -0,0 +1,143 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LITEHTML_DISPLAY_LIST_H__
+#define LITEHTML_DISPLAY_LIST_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "litehtml/background_paint.h"
+#include "litehtml/borders.h"
+#include "litehtml/color.h"
+#include "litehtml/damage_region.h"
+#include "litehtml/list_marker.h"
+#include "litehtml/types.h"
+
+namespace litehtml {
+
+class Document;
+class DocumentContainer;
+
+// The container calls a document makes to draw itself, recorded once so
+// they can be replayed any number of times without walking the elements.
+// The recording is only valid until the document is laid out again.
+class DisplayList {
+public:
+    enum ItemType {
+        kItemText,
+        kItemBackground,
+        kItemBorders,
+        kItemListMarker,
+        kItemSetClip,
+        kItemDelClip,
+    };
+
+private:
+    struct Item {
+        ItemType type;
+
+        // The index of the call's arguments in the vector for its type.
+        int index;
+
+        // The area the call draws to (unused for clip items).
+        Position bounds;
+    };
+
+    struct TextCall {
+        std::string text;
+        uintptr_t font;
+        Color color;
+        Position pos;
+    };
+
+    struct BordersCall {
+        Borders borders;
+        Position draw_pos;
+        bool root;
+    };
+
+    struct ClipCall {
+        Position pos;
+        BorderRadii border_radii;
+        bool valid_x;
+        bool valid_y;
+    };
+
+    class Recorder;
+
+    std::vector<Item> items_;
+    std::vector<TextCall> texts_;
+    std::vector<BackgroundPaint> backgrounds_;
+    std::vector<BordersCall> borders_;
+    std::vector<list_marker> markers_;
+    std::vector<ClipCall> clips_;
+
+    // Where the document was recorded at.
+    int x_ = 0;
+    int y_ = 0;
+
+public:
+    // Records the calls document->draw(hdc, x, y, nullptr) makes. Fixed
+    // positioned elements are drawn relative to the client rectangle, so
+    // the recording can't be moved to another (x, y).
+    void record(Document* document, int x, int y);
+
+    // Makes the recorded calls on container with hdc, skipping the ones that
+    // draw outside clip (if clip isn't null). The container must be the one
+    // the document's fonts were created with.
+    void replay(DocumentContainer* container,
+        uintptr_t hdc,
+        const Position* clip) const;
+
+    // Replays the calls that draw in each rectangle of region (in document
+    // coordinates) with the rectangle set as the clip, like
+    // Document::draw(hdc, x, y, region).
+    void replay(DocumentContainer* container,
+        uintptr_t hdc,
+        const DamageRegion& region) const;
+
+    void clear();
+
+    size_t size() const
+    {
+        return items_.size();
+    }
+
+    ItemType type(size_t index) const
+    {
+        return items_[index].type;
+    }
+};
+
+} // namespace litehtml
+
+#endif // LITEHTML_DISPLAY_LIST_H__
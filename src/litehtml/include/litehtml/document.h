@@ -31,17 +31,28 @@
 #ifndef LITEHTML_DOCUMENT_H__
 #define LITEHTML_DOCUMENT_H__
 
+#include <functional>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "litehtml/color.h"
 #include "litehtml/context.h"
 #include "litehtml/css/css_style.h"
+#include "litehtml/damage_region.h"
 #include "litehtml/debug/json.h"
 #include "litehtml/element/element.h"
+#include "litehtml/render_tree.h"
+#include "litehtml/text_width_cache.h"
 #include "litehtml/types.h"
 #include "litehtml/url.h"
 
+#if defined(USE_ICU)
+#include "unicode/brkiter.h"
+#endif
+
 namespace litehtml {
 
 struct css_text {
@@ -71,6 +82,12 @@ struct css_text {
 };
 
 class HTMLElement;
+class TextElement;
+class ThreadPool;
+
+#if defined(USE_ICU)
+class BreakIteratorCache;
+#endif
 
 class Document : public std::enable_shared_from_this<Document> {
 public:
@@ -92,13 +109,17 @@ private:
 
     Color default_color_;
 
-    Context* context_;
+    const Context* context_;
 
     litehtml::Size m_size;
 
     MediaQueryList::vector m_media_lists;
 
-    Element::ptr m_over_element;
+    // The result of evaluating each media query list against m_media. The
+    // lists themselves may be shared with other documents.
+    std::unordered_map<const MediaQueryList*, bool> media_list_results_;
+
+    Element::ptr m_over_element = nullptr;
 
     ElementsVector m_tabular_elements;
 
@@ -110,15 +131,78 @@ private:
 
     URL base_url_;
 
+    // Incremented by invalidate_layout() to discard every cached layout.
+    int layout_generation_ = 0;
+
+    // Incremented every time render() lays out the document.
+    int layout_count_ = 0;
+
+    // The width, the client rectangle, and the result of the last render.
+    int render_width_ = -1;
+    Position render_client_rect_;
+    int render_result_ = 0;
+
+    // The client rectangle the document is laid out in, if it isn't the
+    // container's (see render_widths()).
+    bool has_viewport_ = false;
+    Position viewport_;
+
+    // The snapshot of the last layout, if render_tree() built it since.
+    RenderTree render_tree_;
+    bool render_tree_valid_ = false;
+
+    // The widths of the strings measured in the document's fonts. Copies of
+    // the document (see clone()) have their own.
+    TextWidthCache text_widths_;
+
+    // See set_track_damage().
+    bool track_damage_ = false;
+    DamageRegion damage_;
+
+    // The area each element drew in after the last render, in document
+    // coordinates and in document order, and the elements whose styles were
+    // parsed since.
+    std::vector<std::pair<const Element*, Position>> damage_boxes_;
+    std::unordered_set<const Element*> changed_elements_;
+
+    // The text elements whose text parse_styles() measures once it parsed
+    // the styles, if it is running.
+    std::vector<TextElement*>* text_batch_ = nullptr;
+
+    // The threads independent subtrees are laid out on, if any (see
+    // set_layout_threads()).
+    std::unique_ptr<ThreadPool> layout_pool_;
+
+#if defined(USE_ICU)
+    std::unique_ptr<BreakIteratorCache> break_iterators_;
+#endif
+
 public:
-    Document(litehtml::DocumentContainer* objContainer, Context* ctx);
+    Document(litehtml::DocumentContainer* objContainer, const Context* ctx);
 
     Document(const URL& base_url,
         litehtml::DocumentContainer* objContainer,
-        Context* ctx);
+        const Context* ctx);
 
     virtual ~Document();
 
+    // Returns a deep copy of the document. The copy shares the parsed
+    // stylesheets with this document, and its text elements keep the widths
+    // measured for this document, so cloning a document is much cheaper
+    // than parsing the same HTML again. The copy starts with an empty text
+    // width cache (font handles belong to the document that created them).
+    // The caller owns the returned document, which must be rendered before
+    // it is drawn.
+    Document* clone() const;
+
+    // Returns a copy of the document rendered at each of the given widths,
+    // with the media queries evaluated against that width. The copies share
+    // the parsed stylesheets with this document. Widths that match the same
+    // media queries share the style computation, and the text widths
+    // measured for it; the other copies measure their text again. The caller
+    // owns the returned documents.
+    std::vector<Document*> render_widths(const std::vector<int>& widths) const;
+
     Element* root()
     {
         return root_.get();
@@ -129,6 +213,10 @@ public:
         return container_;
     }
 
+    // Returns the client rectangle the document is laid out in: the
+    // container's, unless render_widths() gave the document its own.
+    Position client_rect() const;
+
     const CSSStylesheet& stylesheet() const
     {
         return stylesheet_;
@@ -141,10 +229,107 @@ public:
         const char* decoration,
         FontMetrics* fm);
 
+    // Lays out the document. Only the elements that changed since the last
+    // render (see Element::invalidate_layout()) are laid out again; if
+    // nothing changed and max_width is the same, rendering is free.
     int render(int max_width);
 
+    // Discards the layout of every element, so the next render lays out the
+    // whole document again. Containers should call this when something the
+    // layout depends on changes outside of the document (e.g., an image
+    // finished loading).
+    void invalidate_layout();
+
+    int layout_generation() const
+    {
+        return layout_generation_;
+    }
+
+    // Returns a number that changes every time the layout of the document
+    // changes (i.e., the positions of its elements may have moved). Elements
+    // cache what they find from the layout against it.
+    int layout_count() const
+    {
+        return layout_count_;
+    }
+
+    // Returns a compact snapshot of the last layout of the document, built
+    // the first time it is asked for after each render.
+    const RenderTree& render_tree();
+
+    // Lays out independent subtrees (the cells of a table and absolutely
+    // positioned elements) on count threads. The layout is the same as with
+    // a single thread (the default), but the container's callbacks made
+    // during layout must then be thread-safe (see DocumentContainer).
+    void set_layout_threads(int count);
+
+    int layout_threads() const;
+
+    // Calls fn(i) for every i from 0 to count - 1, on the layout threads if
+    // there are any. The calls must not depend on each other.
+    void layout_in_parallel(size_t count, const std::function<void(size_t)>& fn);
+
     void draw(uintptr_t hdc, int x, int y, const Position* clip);
 
+    // Draws the parts of the document in region (in document coordinates),
+    // each rectangle clipped to itself (see DocumentContainer::set_clip()).
+    // Only the elements that draw in the region are visited.
+    void draw(uintptr_t hdc, int x, int y, const DamageRegion& region);
+
+    // Keeps track of the area of the document that has to be drawn again
+    // after it changes (see damage()). Off by default, as it costs each
+    // render a walk over the elements.
+    void set_track_damage(bool track);
+
+    // Returns the area of the document (in document coordinates) that
+    // changed since the last clear_damage(): where the elements whose style
+    // or layout changed, and the elements that moved, were drawn and are
+    // drawn now. Changes are added when the document is rendered.
+    const DamageRegion& damage() const
+    {
+        return damage_;
+    }
+
+    void clear_damage()
+    {
+        damage_.clear();
+    }
+
+    // Called when the styles of element are parsed again.
+    void element_changed(const Element* element)
+    {
+        if (track_damage_) {
+            changed_elements_.insert(element);
+        }
+    }
+
+    // Parses the styles of element and its descendants (see
+    // Element::parse_styles()), then measures the text of all the text
+    // elements among them in one batch (see DocumentContainer::measure_texts()).
+    void parse_styles(Element* element);
+
+    // Adds element to the text elements parse_styles() measures. Returns
+    // false if parse_styles() isn't running; the element then has to measure
+    // its text itself.
+    bool measure_text_later(TextElement* element);
+
+    // Returns the width of text in font. The container only measures each
+    // string once per font; pages repeat the same words many times.
+    int text_width(const char* text, uintptr_t font)
+    {
+        return text_widths_.text_width(container_, text, font);
+    }
+
+    void measure_texts(const TextRun* runs, size_t count, int* widths)
+    {
+        text_widths_.measure_texts(container_, runs, count, widths);
+    }
+
+    const TextWidthCache& text_width_cache() const
+    {
+        return text_widths_;
+    }
+
     Color get_default_color()
     {
         return default_color_;
@@ -185,6 +370,7 @@ public:
         const string_map& attributes);
 
     void add_media_list(MediaQueryList::ptr list);
+    bool is_media_valid(const MediaQueryList* list) const;
     bool media_changed();
     bool lang_changed();
     bool match_lang(const std::string& lang)
@@ -218,6 +404,11 @@ public:
 
     std::string outer_html() const;
 
+#if defined(USE_ICU)
+    // Returns the (cached) line break iterator for the document language.
+    icu::BreakIterator* line_break_iterator();
+#endif
+
 private:
     uintptr_t add_font(const char* name,
         int size,
@@ -227,6 +418,14 @@ private:
         FontMetrics* fm);
 
     void create_node(void* gnode, ElementsVector& elements, bool parseTextNode);
+    void update_language();
+    void discard_stale_paint_orders();
+    void add_damage_boxes(Element* element,
+        int x,
+        int y,
+        std::vector<std::pair<const Element*, Position>>& boxes);
+    void update_damage();
+    void init_fonts(Element* element);
     bool update_media_lists(const MediaFeatures& features);
     void fix_tables_layout();
     void fix_table_children(Element::ptr& el_ptr,
@@ -235,12 +434,16 @@ private:
     void fix_table_parent(Element::ptr& el_ptr,
         Display disp,
         const char* disp_str);
+    Element::ptr create_anonymous_box(Element::ptr parent,
+        ElementsVector& children,
+        const char* disp_str);
 
 public:
 #if defined(ENABLE_JSON)
     nlohmann::json json() const;
 #endif // ENABLE_JSON
 
+    friend class DisplayList;
     friend class DocumentParser;
 };
 
@@ -31,6 +31,7 @@
 #ifndef LITEHTML_DOCUMENT_CONTAINER_H__
 #define LITEHTML_DOCUMENT_CONTAINER_H__
 
+#include <cstddef>
 #include <string>
 
 #include "litehtml/background_paint.h"
@@ -41,7 +42,20 @@
 
 namespace litehtml {
 
+// A string to measure in a font (see DocumentContainer::measure_texts()).
+struct TextRun {
+    const char* text;
+    uintptr_t font;
+};
+
 // call back interface to draw text, images and other elements
+//
+// litehtml calls a container from one thread at a time, except while a
+// document with layout threads (see Document::set_layout_threads()) is
+// rendered: the callbacks made during layout, get_client_rect() and
+// get_image_size(), may then be called from several threads at once and
+// must be thread-safe. A container shared between documents rendered on
+// different threads must make all of its callbacks thread-safe.
 class DocumentContainer {
 public:
     virtual ~DocumentContainer() = default;
@@ -58,6 +72,11 @@ public:
     virtual int text_width(const char* text,
         uintptr_t hFont) = 0;
 
+    // Sets widths[i] to the width of runs[i] for every i from 0 to count - 1.
+    // Containers can override this to share the setup of measuring text
+    // between the runs; by default it calls text_width() for each run.
+    virtual void measure_texts(const TextRun* runs, size_t count, int* widths);
+
     virtual void draw_text(uintptr_t hdc,
         const char* text,
         uintptr_t hFont,
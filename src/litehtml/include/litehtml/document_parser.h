@@ -39,20 +39,20 @@ public:
     static Document* parse(const String& html,
         const URL& base_url,
         DocumentContainer* container,
-        Context* context,
+        const Context* context,
         CSSStylesheet* user_stylesheet = nullptr);
 
     static Document* parse(const char* html,
         const URL& base_url,
         DocumentContainer* container,
-        Context* context,
+        const Context* context,
         CSSStylesheet* user_stylesheet = nullptr);
 
     static Document* parse(const char* html,
         size_t length,
         const URL& base_url,
         DocumentContainer* container,
-        Context* context,
+        const Context* context,
         CSSStylesheet* user_stylesheet = nullptr);
 };
 
@@ -40,6 +40,8 @@ public:
     explicit AnchorElement(Document* doc);
     virtual ~AnchorElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementAnchor;
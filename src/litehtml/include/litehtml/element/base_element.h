@@ -40,6 +40,8 @@ public:
     BaseElement(Document* doc);
     virtual ~BaseElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementBase;
@@ -59,6 +59,8 @@ public:
 
     virtual ~BeforeElement();
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementBefore;
@@ -79,6 +81,8 @@ public:
     }
 
     virtual ~AfterElement();
+
+    virtual Element* clone(Document* document) const override;
 };
 
 } // namespace litehtml
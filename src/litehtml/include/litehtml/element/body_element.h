@@ -40,6 +40,8 @@ public:
     BodyElement(Document* doc);
     virtual ~BodyElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementBody;
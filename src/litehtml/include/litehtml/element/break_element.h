@@ -40,6 +40,8 @@ public:
     BreakElement(Document* doc);
     virtual ~BreakElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementBreak;
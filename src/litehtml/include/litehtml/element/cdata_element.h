@@ -42,6 +42,8 @@ public:
     CDATAElement(Document* doc);
     virtual ~CDATAElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementCDATA;
@@ -42,6 +42,8 @@ public:
     CommentElement(Document* doc);
     virtual ~CommentElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementComment;
@@ -40,6 +40,8 @@ public:
     DivElement(Document* doc);
     virtual ~DivElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementDiv;
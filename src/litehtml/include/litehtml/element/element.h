@@ -32,6 +32,7 @@
 #define LITEHTML_ELEMENT_H__
 
 #include <memory>
+#include <vector>
 
 #include "litehtml/background.h"
 #include "litehtml/color.h"
@@ -84,6 +85,45 @@ enum Directionality {
 
 String element_type_name(ElementType type);
 
+class Element;
+
+// One of the calls a stacking context makes to draw its descendants (see
+// Element::add_paint_steps()). x and y are relative to the stacking context.
+struct PaintStep {
+    enum Type {
+        // element->draw()
+        kDraw,
+
+        // element->draw(), then element->draw_stacking_context()
+        kDrawStackingContext,
+
+        // element->draw_background() (e.g., a table row)
+        kDrawBackground,
+
+        // Clip to the padding box of element (overflow other than visible).
+        kSetClip,
+        kDelClip,
+    };
+
+    Type type;
+    Element* element;
+    int x;
+    int y;
+
+    // Drawn at the origin of the client rectangle instead of x, y (position:
+    // fixed).
+    bool fixed;
+
+    // For kDrawStackingContext.
+    bool with_positioned;
+
+    // The area the step draws in, relative to the stacking context, if
+    // bounded (see Element::get_paint_bounds()). The clip steps cover the
+    // steps between them.
+    bool bounded;
+    Position bounds;
+};
+
 class Element : public std::enable_shared_from_this<Element> {
     friend class BlockBox;
     friend class LineBox;
@@ -128,8 +168,24 @@ protected:
     // skip is always true for certain elements (e.g., comments).
     bool m_skip;
 
+    // True if the element (or one of its descendants) changed since the
+    // element was last rendered. See invalidate_layout().
+    bool layout_dirty_ = true;
+
+    // The Document::layout_count() when invalidate_layout() last marked the
+    // element (-1 if it never did).
+    int layout_dirty_count_ = -1;
+
     virtual void select_all(const CSSSelector& selector, ElementsVector& res);
 
+    // Copy the element's style and box model state. The copy has no parent,
+    // no children, and no layout state. See also clone().
+    Element(const Element& element);
+
+    // Append deep copies of this element's children to copy, reparent copy
+    // (and its children) to document, and return copy.
+    Element* clone_children(Element* copy, Document* document) const;
+
 public:
     Element() = delete;
 
@@ -137,6 +193,22 @@ public:
 
     virtual ~Element();
 
+    // Returns a deep copy of the element and its children that belongs to
+    // document. The copy shares immutable style data (e.g., selectors) with
+    // the original but does not copy layout state, so the copy must be
+    // rendered before it can be drawn.
+    virtual Element* clone(Document* document) const;
+
+    // Marks the element and its ancestors as needing layout. Rendering
+    // reuses the previous layout of elements that are not marked. Must not
+    // be called while the document is rendered.
+    void invalidate_layout();
+
+    bool needs_layout() const
+    {
+        return layout_dirty_;
+    }
+
     Position& get_position()
     {
       return position_;
@@ -385,6 +457,15 @@ public:
     virtual void draw(uintptr_t hdc, int x, int y, const Position* clip);
     virtual void draw_background(uintptr_t hdc, int x, int y, const Position* clip);
 
+    // Sets bounds to the area draw() draws in, relative to the content box of
+    // the parent. Returns false if draw() may draw outside of it.
+    virtual bool get_draw_bounds(Position& bounds);
+
+    // Sets bounds to the area draw() followed by draw_stacking_context()
+    // draw in, relative to the content box of the parent. Returns false if
+    // they may draw outside of it.
+    virtual bool get_paint_bounds(bool with_positioned, Position& bounds);
+
     virtual const char* get_style_property(CSSProperty name);
 
     virtual const CSSValue* get_style_property_value(CSSProperty property) const;
@@ -414,9 +495,16 @@ public:
     virtual Size get_content_size(int max_width);
     virtual void init();
     virtual bool is_floats_holder() const;
+
+    // Returns true if the width the element needs depends on the available
+    // width only through line breaking: if it fits in a width w with room to
+    // spare, it lays out the same in any width between its own and w.
+    virtual bool is_intrinsically_sized() const;
+
     virtual int get_floats_height(ElementFloat el_float = kFloatNone) const;
     virtual int get_left_floats_height() const;
     virtual int get_right_floats_height() const;
+    virtual size_t get_floats_count() const;
     virtual int get_line_left(int y);
     virtual int get_line_right(int y, int def_right);
     virtual void get_line_left_right(int y, int def_right, int& ln_left, int& ln_right);
@@ -436,6 +524,15 @@ public:
         const Position* clip,
         DrawFlag flag,
         int zindex);
+
+    // Appends the calls draw_children() makes to steps instead of making
+    // them, with x and y relative to the stacking context.
+    virtual void add_paint_steps(std::vector<PaintStep>& steps,
+        int x,
+        int y,
+        DrawFlag flag,
+        int zindex);
+
     virtual bool is_nth_child(const Element::ptr& el,
         int num,
         int off,
@@ -40,6 +40,8 @@ public:
     FontElement(Document* doc);
     virtual ~FontElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementFont;
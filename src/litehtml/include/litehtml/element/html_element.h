@@ -31,6 +31,8 @@
 #ifndef LITEHTML_HTML_ELEMENT_H__
 #define LITEHTML_HTML_ELEMENT_H__
 
+#include <functional>
+
 #include "litehtml/background.h"
 #include "litehtml/background_paint.h"
 #include "litehtml/borders.h"
@@ -40,6 +42,7 @@
 #include "litehtml/css/css_stylesheet.h"
 #include "litehtml/element/element.h"
 #include "litehtml/css/css_style.h"
+#include "litehtml/float_index.h"
 #include "litehtml/table.h"
 
 namespace litehtml {
@@ -115,8 +118,68 @@ protected:
     int m_z_index;
     BoxSizing box_sizing_;
 
-    int_int_cache m_cahe_line_left;
-    int_int_cache m_cahe_line_right;
+    // The extents of m_floats_left and m_floats_right, for answering line
+    // queries without scanning every float.
+    FloatIndex floats_index_;
+
+    // The result of the last render. If the element hasn't changed since and
+    // is rendered with the same width (and the same parent height) the result
+    // is reused and the element is only moved. See HTMLElement::render() for
+    // when the result depends on the floats around the element.
+    struct LayoutCache {
+        bool valid = false;
+        int generation = 0;
+        int max_width = 0;
+        int containing_height = -1;
+        bool second_pass = false;
+        int width = 0;
+        Position position;
+        Margins margin;
+        Margins border;
+        Margins padding;
+    };
+    LayoutCache layout_cache_;
+
+    // Whether the width of the element's contents depends on the available
+    // width only through line breaking (see calc_intrinsically_sized()). Set
+    // by the last render.
+    bool intrinsically_sized_ = false;
+
+    // The width a shrink-to-fit element (e.g., an inline-block) found for
+    // its contents in the last first pass of render_box(). If the contents
+    // are intrinsically sized, the first pass finds the same width for any
+    // available width from min_width to max_width.
+    struct ShrinkToFitCache {
+        bool valid = false;
+        int generation = 0;
+        int min_width = 0;
+        int max_width = 0;
+        int width = 0;
+    };
+    ShrinkToFitCache shrink_to_fit_cache_;
+
+    // The calls draw_stacking_context() makes to draw the descendants of the
+    // element, in paint order, and the layout they were found for (see
+    // Document::layout_count()). Building the list takes a pass over the
+    // descendants for every z-index and every DrawFlag; drawing it doesn't.
+    // get_element_by_point() looks for the element at a point in the same
+    // list, backwards.
+    struct PaintOrder {
+        int layout_count = -1;
+        bool with_positioned = false;
+        std::vector<PaintStep> steps;
+
+        // Whether every step is bounded, and the area the bounded steps
+        // cover.
+        bool bounded = true;
+        Position bounds;
+
+        // For long lists, the steps that draw in each horizontal band of the
+        // bounds (see find_paint_steps()), so drawing a small part of a tall
+        // element only looks at the steps near it.
+        std::vector<std::vector<int>> bands;
+    };
+    PaintOrder paint_order_;
 
     // data for table rendering
     std::unique_ptr<table_grid> m_grid;
@@ -125,14 +188,19 @@ protected:
     int m_border_spacing_x;
     int m_border_spacing_y;
     border_collapse m_border_collapse;
+    TableLayout table_layout_;
 
     virtual void select_all(const CSSSelector& selector,
         ElementsVector& res) override;
 
+    HTMLElement(const HTMLElement& element);
+
 public:
     HTMLElement(Document* doc);
     virtual ~HTMLElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementHTML;
@@ -205,6 +273,8 @@ public:
     virtual void parse_styles(bool is_reparse = false) override;
     virtual void draw(uintptr_t hdc, int x, int y, const Position* clip) override;
     virtual void draw_background(uintptr_t hdc, int x, int y, const Position* clip) override;
+    virtual bool get_draw_bounds(Position& bounds) override;
+    virtual bool get_paint_bounds(bool with_positioned, Position& bounds) override;
 
     virtual const char* get_style_property(CSSProperty name) override;
 
@@ -248,9 +318,11 @@ public:
     virtual void init() override;
     virtual void get_inline_boxes(std::vector<Position>& boxes) override;
     virtual bool is_floats_holder() const override;
+    virtual bool is_intrinsically_sized() const override;
     virtual int get_floats_height(ElementFloat el_float = kFloatNone) const override;
     virtual int get_left_floats_height() const override;
     virtual int get_right_floats_height() const override;
+    virtual size_t get_floats_count() const override;
     virtual int get_line_left(int y) override;
     virtual int get_line_right(int y, int def_right) override;
     virtual void get_line_left_right(int y,
@@ -268,6 +340,11 @@ public:
         const Position* clip,
         DrawFlag flag,
         int zindex) override;
+    virtual void add_paint_steps(std::vector<PaintStep>& steps,
+        int x,
+        int y,
+        DrawFlag flag,
+        int zindex) override;
     virtual int get_zindex() const override;
     virtual void draw_stacking_context(uintptr_t hdc,
         int x,
@@ -302,21 +379,52 @@ public:
     virtual std::string outer_html() const override;
 
 protected:
-    void draw_children_box(uintptr_t hdc,
+    void add_paint_steps_box(std::vector<PaintStep>& steps,
         int x,
         int y,
-        const Position* clip,
         DrawFlag flag,
         int zindex);
-    void draw_children_table(uintptr_t hdc,
+    void add_paint_steps_table(std::vector<PaintStep>& steps,
         int x,
         int y,
-        const Position* clip,
         DrawFlag flag,
         int zindex);
+    void add_paint_step(std::vector<PaintStep>& steps,
+        PaintStep::Type type,
+        Element* element,
+        int x,
+        int y,
+        bool fixed = false,
+        bool with_positioned = false);
+    const PaintOrder& paint_order(bool with_positioned);
+    void find_paint_steps(const PaintOrder& order,
+        int top,
+        int bottom,
+        std::vector<int>& result) const;
+    void draw_paint_steps(uintptr_t hdc,
+        int x,
+        int y,
+        const Position* clip,
+        const std::vector<PaintStep>& steps,
+        const std::vector<int>* indices = nullptr);
+    Element::ptr get_paint_step_by_point(const std::vector<PaintStep>& steps,
+        const std::vector<int>* indices,
+        int x,
+        int y,
+        int client_x,
+        int client_y);
+    void set_overflow_clip(int x, int y);
     int render_box(int x, int y, int max_width, bool second_pass = false);
     int render_table(int x, int y, int max_width, bool second_pass = false);
+    void measure_table_cell(table_cell* cell, int available);
+    void layout_table_cells(
+        const std::function<void(int col, table_cell* cell)>& fn);
     int fix_line_width(int max_width, ElementFloat flt);
+    void rebuild_floats_index();
+    bool is_shrink_to_fit() const;
+    void render_positioned_element(const Element::ptr& el,
+        const Position& wnd_position);
+    bool calc_intrinsically_sized() const;
     void parse_background();
     void init_BackgroundPaint(Position pos,
         BackgroundPaint& bg_paint,
@@ -42,6 +42,8 @@ public:
     ImageElement(Document* doc);
     virtual ~ImageElement(void) override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementImage;
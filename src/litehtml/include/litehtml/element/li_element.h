@@ -39,6 +39,8 @@ public:
     LiElement(Document* doc);
     virtual ~LiElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementLI;
@@ -39,6 +39,8 @@ public:
     LinkElement(Document* doc);
     virtual ~LinkElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementLink;
@@ -40,6 +40,8 @@ public:
     ParagraphElement(Document* doc);
     virtual ~ParagraphElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementParagraph;
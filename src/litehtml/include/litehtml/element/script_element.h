@@ -45,6 +45,8 @@ public:
     ScriptElement(Document* doc);
     virtual ~ScriptElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementScript;
@@ -36,15 +36,24 @@
 namespace litehtml {
 
 class StyleElement : public Element {
+protected:
+    // The only attribute of a style element the document uses.
+    std::string media_;
+
 public:
     StyleElement(Document* doc);
     virtual ~StyleElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementStyle;
     }
 
+    virtual void set_attr(const char* name, const char* val) override;
+    virtual const char* get_attr(const char* name,
+        const char* def = nullptr) const override;
     virtual void parse_attributes() override;
     virtual bool append_child(Element* element) override;
     virtual const char* get_tagName() const override;
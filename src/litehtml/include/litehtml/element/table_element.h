@@ -45,6 +45,8 @@ public:
     TableElement(Document* doc);
     virtual ~TableElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementTable;
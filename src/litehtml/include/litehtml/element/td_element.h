@@ -40,6 +40,8 @@ public:
     TdElement(Document* doc);
     virtual ~TdElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementTD;
@@ -50,6 +50,11 @@ protected:
 
     bool draw_spaces_ = true;
 
+    const char* measured_text() const
+    {
+        return use_transformed_ ? transformed_text_.c_str() : text_.c_str();
+    }
+
 public:
     TextElement() = delete;
 
@@ -61,6 +66,13 @@ public:
 
     virtual ~TextElement() override;
 
+    // Measures the text of the elements in one batch (see
+    // Document::parse_styles()).
+    static void measure(Document* document,
+        const std::vector<TextElement*>& elements);
+
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementText;
@@ -78,6 +90,7 @@ public:
     virtual int line_height() const override;
     virtual uintptr_t get_font(FontMetrics* fm = nullptr) override;
     virtual Display get_display() const override;
+    virtual bool is_intrinsically_sized() const override;
     virtual WhiteSpace get_white_space() const override;
     virtual ElementPosition get_element_position(
         CSSOffsets* offsets = nullptr) const override;
@@ -40,6 +40,8 @@ public:
     TitleElement(Document* doc);
     virtual ~TitleElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementTitle;
@@ -40,6 +40,8 @@ public:
     TrElement(Document* doc);
     virtual ~TrElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementTR;
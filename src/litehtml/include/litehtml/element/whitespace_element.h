@@ -45,6 +45,8 @@ public:
 
     virtual ~WhitespaceElement() override;
 
+    virtual Element* clone(Document* document) const override;
+
     virtual ElementType type() const override
     {
         return kElementWhitespace;
@@ -0,0 +1,92 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LITEHTML_FLOAT_INDEX_H__
+#define LITEHTML_FLOAT_INDEX_H__
+
+#include <map>
+
+#include "litehtml/types.h"
+
+namespace litehtml {
+
+// An index over the vertical extents of the floats in a block formatting
+// context. The index answers how far the floats reach into the line at a
+// given y in logarithmic time, rather than by scanning every float.
+// Adding a float and finding the next line top are still linear in the
+// number of float edges they pass over.
+class FloatIndex {
+    // Each map is a step function of y: an entry (y, value) holds the value
+    // from y up to the next entry. There is an entry at the top and at the
+    // bottom of every float.
+
+    // The right edge of the left floats (0 if there are none at y).
+    std::map<int, int> left_;
+
+    // The left edge of the right floats (INT_MAX if there are none at y).
+    std::map<int, int> right_;
+
+    int left_bottom_ = 0;
+
+    int right_bottom_ = 0;
+
+public:
+    void clear();
+
+    void add(const floated_box& fb);
+
+    // Returns the left edge of the line at y.
+    int line_left(int y) const;
+
+    // Returns the right edge of the line at y, which is at most def_right.
+    int line_right(int y, int def_right) const;
+
+    // Returns the first top or bottom of a float at or below top where a
+    // line is at least width wide. If there is no such position, returns the
+    // lowest top or bottom of a float (or top if there are no floats below
+    // it). Takes time linear in the number of float edges it passes before
+    // finding a wide enough line.
+    int find_next_line_top(int top, int width, int def_right) const;
+
+    // Returns the lowest bottom of the left floats.
+    int left_height() const
+    {
+        return left_bottom_;
+    }
+
+    // Returns the lowest bottom of the right floats.
+    int right_height() const
+    {
+        return right_bottom_;
+    }
+};
+
+} // namespace litehtml
+
+#endif // LITEHTML_FLOAT_INDEX_H__
@@ -44,7 +44,6 @@ public:
 
 private:
     MediaQuery::vector queries_;
-    bool is_used_ = false;
 
 public:
     MediaQueryList() = default;
@@ -52,13 +51,11 @@ public:
     static MediaQueryList::ptr create_from_string(const std::string& str,
         const Document* doc);
 
-    bool is_used() const
-    {
-        return is_used_;
-    }
-
-    // returns true if the is_used_ changed
-    bool apply_MediaFeatures(const MediaFeatures& features);
+    // Returns true if any of the queries in the list match the features.
+    // Media query lists are shared between documents (e.g., through the
+    // master stylesheet) so the result is stored by the document rather than
+    // by the list. See Document::is_media_valid().
+    bool check(const MediaFeatures& features) const;
 };
 
 } // namespace litehtml
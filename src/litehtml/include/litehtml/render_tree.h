@@ -0,0 +1,121 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LITEHTML_RENDER_TREE_H__
+#define LITEHTML_RENDER_TREE_H__
+
+#include <cstddef>
+#include <vector>
+
+#include "litehtml/types.h"
+
+namespace litehtml {
+
+class Element;
+
+// A compact snapshot of the layout of a document. The boxes of the laid out
+// elements (text excluded) are packed in one array in document order, with
+// their positions in document coordinates and their relations as indices
+// into the array, so queries over the layout don't have to walk the
+// elements themselves. The snapshot stays as it is when the document is laid
+// out again (e.g., at another width), but it refers to the elements, so it
+// must not be used once any of them are removed.
+class RenderTree {
+public:
+    struct Box {
+        Element* element = nullptr;
+
+        // The border box of the element. Inline elements have a box for each
+        // line they are on instead (see fragments()); their position covers
+        // all of them.
+        Position position;
+
+        // The area covered by the element and all of its descendants.
+        Position bounds;
+
+        // The index of the parent box (or -1 for the root).
+        int parent = -1;
+
+        // The index after the last descendant of the box, so the descendants
+        // of box i are the boxes from i + 1 to end - 1.
+        int end = 0;
+
+        // The range of the element's line boxes in fragments().
+        int first_fragment = 0;
+        int fragment_count = 0;
+
+        bool visible = false;
+    };
+
+private:
+    std::vector<Box> boxes_;
+
+    std::vector<Position> fragments_;
+
+    void add(Element* element, int parent, int x, int y);
+
+public:
+    // Replaces the snapshot with the layout of root and its descendants.
+    void build(Element* root);
+
+    void clear();
+
+    bool empty() const
+    {
+        return boxes_.empty();
+    }
+
+    const std::vector<Box>& boxes() const
+    {
+        return boxes_;
+    }
+
+    const std::vector<Position>& fragments() const
+    {
+        return fragments_;
+    }
+
+    // Appends the indices of the visible boxes that intersect rect to result,
+    // in document order.
+    void intersecting(const Position& rect, std::vector<int>& result) const;
+
+    // Returns the index of the last visible box in document order that
+    // contains the point (so descendants take precedence over their
+    // ancestors), or -1 if there is none. Unlike
+    // Element::get_element_by_point(), this doesn't consider z-index.
+    int box_at(int x, int y) const;
+
+    // Returns the number of bytes the snapshot uses.
+    size_t memory_usage() const;
+};
+
+} // namespace litehtml
+
+#endif // LITEHTML_RENDER_TREE_H__
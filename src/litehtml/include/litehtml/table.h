@@ -106,6 +106,9 @@ struct table_column {
     int max_width;
     int width;
     CSSLength css_width;
+    // The width of the column's cell in the first row, which is the only
+    // one 'table-layout: fixed' looks at.
+    CSSLength fixed_css_width;
     int border_left;
     int border_right;
     int left;
@@ -121,6 +124,7 @@ struct table_column {
         max_width = 0;
         width = 0;
         css_width.predef(0);
+        fixed_css_width.predef(0);
     }
 
     table_column(int min_w, int max_w)
@@ -133,6 +137,7 @@ struct table_column {
         min_width = min_w;
         width = 0;
         css_width.predef(0);
+        fixed_css_width.predef(0);
     }
 
     table_column(const table_column& val)
@@ -145,30 +150,10 @@ struct table_column {
         min_width = val.min_width;
         width = val.width;
         css_width = val.css_width;
+        fixed_css_width = val.fixed_css_width;
     }
 };
 
-class table_column_accessor {
-public:
-    virtual ~table_column_accessor();
-    virtual int& get(table_column& col) = 0;
-};
-
-class table_column_accessor_max_width : public table_column_accessor {
-public:
-    virtual int& get(table_column& col);
-};
-
-class table_column_accessor_min_width : public table_column_accessor {
-public:
-    virtual int& get(table_column& col);
-};
-
-class table_column_accessor_width : public table_column_accessor {
-public:
-    virtual int& get(table_column& col);
-};
-
 struct table_cell {
     Element::ptr el;
     int colspan;
@@ -181,6 +166,14 @@ struct table_cell {
     int height;
     Margins borders;
 
+    // Set when min_width and max_width were measured by rendering the cell
+    // (see HTMLElement::render_table()). They stay valid while the cell and
+    // the document layout generation are unchanged; max_width was measured
+    // against measured_available.
+    bool measured;
+    int measured_generation;
+    int measured_available;
+
     table_cell()
     {
         min_width = 0;
@@ -192,6 +185,9 @@ struct table_cell {
         colspan = 1;
         rowspan = 1;
         el = nullptr;
+        measured = false;
+        measured_generation = 0;
+        measured_available = 0;
     }
 
     table_cell(const table_cell& val)
@@ -206,6 +202,9 @@ struct table_cell {
         max_width = val.max_width;
         max_height = val.max_height;
         borders = val.borders;
+        measured = val.measured;
+        measured_generation = val.measured_generation;
+        measured_available = val.measured_available;
     }
 
     table_cell(const table_cell&& val)
@@ -220,6 +219,9 @@ struct table_cell {
         max_width = val.max_width;
         max_height = val.max_height;
         borders = val.borders;
+        measured = val.measured;
+        measured_generation = val.measured_generation;
+        measured_available = val.measured_available;
     }
 };
 
@@ -231,6 +233,9 @@ private:
     int m_rows_count;
     int m_cols_count;
     rows m_cells;
+    // The last row spanned by a cell in each column, so checking whether a
+    // cell is covered by a rowspan doesn't have to look at every earlier row.
+    std::vector<int> m_rowspan_end;
     table_column::vector m_columns;
     table_row::vector m_rows;
 
@@ -268,11 +273,15 @@ public:
     void distribute_max_width(int width, int start, int end);
     void distribute_min_width(int width, int start, int end);
     void distribute_width(int width, int start, int end);
-    void distribute_width(int width, int start, int end, table_column_accessor* acc);
+    void distribute_width(int width, int start, int end, int table_column::*member);
     int calc_table_width(int block_width,
         bool is_auto,
         int& min_table_width,
         int& max_table_width);
+    // Calculates the column widths of a table with 'table-layout: fixed' from
+    // the column widths and the table width alone, without looking at the
+    // cell contents.
+    int calc_fixed_table_width(int block_width);
     void calc_horizontal_positions(Margins& table_borders,
         border_collapse bc,
         int bdr_space_x);
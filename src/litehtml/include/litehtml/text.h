@@ -113,4 +113,16 @@ inline bool is_whitespace(char32_t c)
     return lookup(whitespace_lookup, c);
 }
 
+// Returns a pointer to the first whitespace character in [begin, end) or end
+// if the range contains no whitespace characters.
+//
+// is_whitespace() only accepts ASCII characters and UTF-8 encodes non-ASCII
+// code points using bytes >= 0x80, so the UTF-8 encoded text can be scanned
+// a byte at a time (or a vector at a time) without decoding it.
+const char* find_whitespace(const char* begin, const char* end);
+
+// Returns a pointer to the first non-whitespace character in [begin, end) or
+// end if the range contains only whitespace characters.
+const char* find_non_whitespace(const char* begin, const char* end);
+
 } // namespace litehtml
@@ -0,0 +1,145 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LITEHTML_TEXT_WIDTH_CACHE_H__
+#define LITEHTML_TEXT_WIDTH_CACHE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace litehtml {
+
+class DocumentContainer;
+struct TextRun;
+
+// Remembers the widths the container measured for strings in a font, so the
+// words that repeat throughout a page are only measured once per font. The
+// cache holds at most capacity widths, and drops the least recently used
+// ones once it is full.
+//
+// Text is measured while styles are parsed (text elements) and while the
+// document is drawn (list markers), not on the layout threads (see
+// Document::set_layout_threads()). The cache is still locked, so that it
+// stays safe if text is ever measured during layout; the lock is
+// uncontended today.
+class TextWidthCache {
+public:
+    static const size_t kDefaultCapacity = 16384;
+
+    struct Stats {
+        // Lookups that found a width.
+        size_t hits = 0;
+
+        // Lookups that didn't (i.e., calls to the container).
+        size_t misses = 0;
+
+        // Widths dropped to make room for others.
+        size_t evictions = 0;
+    };
+
+private:
+    struct Key {
+        uintptr_t font;
+        std::string text;
+
+        bool operator==(const Key& other) const
+        {
+            return font == other.font && text == other.text;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<std::string>()(key.text) ^
+                   (std::hash<uintptr_t>()(key.font) * 31);
+        }
+    };
+
+    struct Entry {
+        int width;
+        std::list<Key>::iterator lru;
+    };
+
+    size_t capacity_;
+
+    mutable std::mutex mutex_;
+
+    std::unordered_map<Key, Entry, KeyHash> widths_;
+
+    // The keys from the most to the least recently used.
+    std::list<Key> lru_;
+
+    Stats stats_;
+
+    // Sets width to the cached width of key (marking it as the most recently
+    // used) and returns true, or returns false if it isn't cached. The mutex
+    // must be held.
+    bool find(const Key& key, int& width);
+
+    // Adds the width of key, dropping the least recently used widths if the
+    // cache is full. The mutex must be held.
+    void add(const Key& key, int width);
+
+public:
+    explicit TextWidthCache(size_t capacity = kDefaultCapacity);
+
+    // Returns the width of text in font, asking the container to measure it
+    // if the width isn't cached.
+    int text_width(DocumentContainer* container, const char* text, uintptr_t font);
+
+    // Sets widths[i] to the width of runs[i] for every i from 0 to count - 1.
+    // The container measures the runs that aren't cached in one call to
+    // measure_texts(), and each distinct run only once.
+    void measure_texts(DocumentContainer* container,
+        const TextRun* runs,
+        size_t count,
+        int* widths);
+
+    void clear();
+
+    size_t size() const;
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    Stats stats() const;
+};
+
+} // namespace litehtml
+
+#endif // LITEHTML_TEXT_WIDTH_CACHE_H__
@@ -0,0 +1,101 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LITEHTML_THREAD_POOL_H__
+#define LITEHTML_THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace litehtml {
+
+// A fixed set of worker threads that run the iterations of a loop in
+// parallel. The thread that starts the loop takes part in it, and every
+// thread claims the next iteration as soon as it finishes one, so a few slow
+// iterations don't hold up the others.
+class ThreadPool {
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+
+    // Signalled when a loop starts or the pool is destroyed.
+    std::condition_variable start_;
+
+    // Signalled when the last worker finishes its part of a loop.
+    std::condition_variable done_;
+
+    // The loop being run. The workers only read these while they take part
+    // in the loop.
+    const std::function<void(size_t)>* fn_ = nullptr;
+    size_t count_ = 0;
+    std::atomic<size_t> next_;
+
+    // Incremented for every loop, so the workers can tell a new loop from
+    // the one they just finished.
+    unsigned long loop_ = 0;
+
+    // The number of workers that haven't finished their part of the loop.
+    int busy_ = 0;
+
+    bool stop_ = false;
+
+    void worker();
+
+    void run();
+
+public:
+    // Creates a pool of threads threads, including the thread that calls
+    // parallel_for().
+    explicit ThreadPool(int threads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int threads() const
+    {
+        return (int)threads_.size() + 1;
+    }
+
+    // Calls fn(i) for every i from 0 to count - 1, and returns when all the
+    // calls returned. Loops started from inside fn run on the calling thread
+    // alone.
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+};
+
+} // namespace litehtml
+
+#endif // LITEHTML_THREAD_POOL_H__
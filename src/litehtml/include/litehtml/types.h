@@ -32,6 +32,7 @@
 #define LITEHTML_TYPES_H__
 #include <stdlib.h>
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
@@ -170,6 +171,19 @@ struct Position {
                    val->bottom() >= top() && val->top() <= bottom());
     }
 
+    // Grows the rectangle to cover val too.
+    void unite(const Position& val)
+    {
+        int new_left = std::min(left(), val.left());
+        int new_top = std::min(top(), val.top());
+        int new_right = std::max(right(), val.right());
+        int new_bottom = std::max(bottom(), val.bottom());
+        x = new_left;
+        y = new_top;
+        width = new_right - new_left;
+        height = new_bottom - new_top;
+    }
+
     bool empty() const
     {
         if (!width && !height) {
@@ -433,6 +447,11 @@ enum ElementPosition {
     kPositionFixed,
 };
 
+enum TableLayout {
+    kTableLayoutAuto,
+    kTableLayoutFixed,
+};
+
 enum TextAlign {
     kTextAlignLeft,
     kTextAlignRight,
@@ -560,32 +579,6 @@ struct floated_box {
     }
 };
 
-struct int_int_cache {
-    int hash;
-    int val;
-    bool is_valid;
-    bool is_default;
-
-    int_int_cache()
-    {
-        hash = 0;
-        val = 0;
-        is_valid = false;
-        is_default = false;
-    }
-    void invalidate()
-    {
-        is_valid = false;
-        is_default = false;
-    }
-    void set_value(int vHash, int vVal)
-    {
-        hash = vHash;
-        val = vVal;
-        is_valid = true;
-    }
-};
-
 enum select_result {
     select_no_match = 0x00,
     select_match = 0x01,
@@ -60,21 +60,14 @@ MediaQueryList::ptr MediaQueryList::create_from_string(const std::string& str,
     return list;
 }
 
-bool MediaQueryList::apply_MediaFeatures(const MediaFeatures& features)
+bool MediaQueryList::check(const MediaFeatures& features) const
 {
-    bool apply = false;
-
-    for (MediaQuery::vector::iterator iter = queries_.begin();
-         iter != queries_.end() && !apply;
-         iter++) {
-        if ((*iter)->check(features)) {
-            apply = true;
+    for (const auto& query : queries_) {
+        if (query->check(features)) {
+            return true;
         }
     }
-
-    bool ret = (apply != is_used_);
-    is_used_ = apply;
-    return ret;
+    return false;
 }
 
 } // namespace litehtml
@@ -0,0 +1,166 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/render_tree.h"
+
+#include "litehtml/element/element.h"
+
+namespace litehtml {
+
+void RenderTree::build(Element* root)
+{
+    clear();
+    if (root) {
+        add(root, -1, 0, 0);
+    }
+}
+
+void RenderTree::clear()
+{
+    boxes_.clear();
+    fragments_.clear();
+}
+
+// Adds the box of element, whose parent's content box is at (x, y), and the
+// boxes of its descendants.
+void RenderTree::add(Element* element, int parent, int x, int y)
+{
+    Box box;
+    box.element = element;
+    box.parent = parent;
+    box.visible = element->is_visible();
+
+    const Position& content = element->get_position();
+    box.position = content;
+    box.position += element->padding();
+    box.position += element->border();
+    box.position.x += x;
+    box.position.y += y;
+
+    box.first_fragment = (int)fragments_.size();
+    if (element->get_display() == kDisplayInline) {
+        std::vector<Position> fragments;
+        element->get_inline_boxes(fragments);
+        for (size_t i = 0; i < fragments.size(); i++) {
+            fragments[i].x += x;
+            fragments[i].y += y;
+            if (i == 0) {
+                box.position = fragments[i];
+            } else {
+                box.position.unite(fragments[i]);
+            }
+            fragments_.push_back(fragments[i]);
+        }
+        box.fragment_count = (int)fragments.size();
+    }
+    box.bounds = box.position;
+
+    int index = (int)boxes_.size();
+    boxes_.push_back(box);
+
+    int child_x = x + content.x;
+    int child_y = y + content.y;
+    for (size_t i = 0; i < element->get_children_count(); i++) {
+        Element* child = element->get_child((int)i);
+        if (child->skip() || child->get_display() == kDisplayNone ||
+            child->get_display() == kDisplayInlineText) {
+            continue;
+        }
+
+        int child_index = (int)boxes_.size();
+        add(child, index, child_x, child_y);
+        boxes_[index].bounds.unite(boxes_[child_index].bounds);
+    }
+
+    boxes_[index].end = (int)boxes_.size();
+}
+
+void RenderTree::intersecting(const Position& rect,
+    std::vector<int>& result) const
+{
+    int i = 0;
+    while (i < (int)boxes_.size()) {
+        const Box& box = boxes_[i];
+        if (!box.bounds.does_intersect(&rect)) {
+            i = box.end;
+            continue;
+        }
+
+        if (box.visible) {
+            if (box.fragment_count) {
+                for (int j = 0; j < box.fragment_count; j++) {
+                    if (fragments_[box.first_fragment + j].does_intersect(&rect)) {
+                        result.push_back(i);
+                        break;
+                    }
+                }
+            } else if (box.position.does_intersect(&rect)) {
+                result.push_back(i);
+            }
+        }
+        i++;
+    }
+}
+
+int RenderTree::box_at(int x, int y) const
+{
+    int result = -1;
+    int i = 0;
+    while (i < (int)boxes_.size()) {
+        const Box& box = boxes_[i];
+        if (!box.bounds.is_point_inside(x, y)) {
+            i = box.end;
+            continue;
+        }
+
+        if (box.visible) {
+            if (box.fragment_count) {
+                for (int j = 0; j < box.fragment_count; j++) {
+                    if (fragments_[box.first_fragment + j].is_point_inside(x, y)) {
+                        result = i;
+                        break;
+                    }
+                }
+            } else if (box.position.is_point_inside(x, y)) {
+                result = i;
+            }
+        }
+        i++;
+    }
+    return result;
+}
+
+size_t RenderTree::memory_usage() const
+{
+    return sizeof(RenderTree) + boxes_.capacity() * sizeof(Box) +
+           fragments_.capacity() * sizeof(Position);
+}
+
+} // namespace litehtml
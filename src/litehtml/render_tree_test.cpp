@@ -0,0 +1,161 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/render_tree.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "litehtml/context.h"
+#include "litehtml/document.h"
+#include "litehtml/document_parser.h"
+#include "test_container.h"
+
+using namespace litehtml;
+
+namespace {
+
+const char* kHtml =
+    "<html><head><style>"
+    "body, div { display: block }"
+    "span { display: inline }"
+    "b { display: inline-block; width: 30px; height: 10px; visibility: visible }"
+    "#a { width: 200px; height: 100px; padding: 5px; border: 5px solid black }"
+    "#b { margin-left: 20px; width: 50px; height: 20px }"
+    "#c { display: none }"
+    "#d { height: 50px; visibility: hidden }"
+    "</style></head><body>"
+    "<div id=\"a\"><div id=\"b\"></div><div id=\"c\"></div></div>"
+    "<div id=\"d\"><span><b></b> <b></b></span></div>"
+    "</body></html>";
+
+int find(const RenderTree& tree, Element* element)
+{
+    for (size_t i = 0; i < tree.boxes().size(); i++) {
+        if (tree.boxes()[i].element == element) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+TEST(RenderTreeTest, Build)
+{
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(kHtml, URL(), &container, &context);
+    document->render(500);
+
+    const RenderTree& tree = document->render_tree();
+    const std::vector<RenderTree::Box>& boxes = tree.boxes();
+    ASSERT_FALSE(tree.empty());
+    EXPECT_EQ(document->root(), boxes[0].element);
+    EXPECT_EQ(-1, boxes[0].parent);
+    EXPECT_EQ((int)boxes.size(), boxes[0].end);
+
+    // Boxes are in document coordinates, and elements that aren't displayed
+    // have none.
+    Element* a = document->root()->select_one("#a");
+    Element* b = document->root()->select_one("#b");
+    int ia = find(tree, a);
+    int ib = find(tree, b);
+    ASSERT_NE(-1, ia);
+    ASSERT_NE(-1, ib);
+    EXPECT_EQ(-1, find(tree, document->root()->select_one("#c")));
+
+    EXPECT_EQ(0, boxes[ia].position.x);
+    EXPECT_EQ(0, boxes[ia].position.y);
+    EXPECT_EQ(220, boxes[ia].position.width);
+    EXPECT_EQ(120, boxes[ia].position.height);
+    EXPECT_EQ(30, boxes[ib].position.x);
+    EXPECT_EQ(10, boxes[ib].position.y);
+    EXPECT_EQ(50, boxes[ib].position.width);
+    EXPECT_EQ(ia, boxes[ib].parent);
+    EXPECT_EQ(ib + 1, boxes[ia].end);
+
+    // The bounds of a box cover its descendants.
+    EXPECT_LE(boxes[0].bounds.x, boxes[ib].position.x);
+    EXPECT_GE(boxes[0].bounds.bottom(), boxes[ia].position.bottom());
+
+    // Inline elements have a box for each line.
+    int span = find(tree, document->root()->select_one("span"));
+    ASSERT_NE(-1, span);
+    EXPECT_EQ(1, boxes[span].fragment_count);
+    EXPECT_EQ(120, tree.fragments()[boxes[span].first_fragment].y);
+
+    // The snapshot doesn't change when the document is laid out again.
+    RenderTree snapshot = tree;
+    document->render(100);
+    EXPECT_EQ(snapshot.boxes()[ib].position.x, boxes[ib].position.x);
+    EXPECT_EQ(b, document->render_tree().boxes()[ib].element);
+
+    delete document;
+}
+
+TEST(RenderTreeTest, Queries)
+{
+    Context context;
+    test_container container;
+    Document* document = DocumentParser::parse(kHtml, URL(), &container, &context);
+    document->render(500);
+
+    const RenderTree& tree = document->render_tree();
+    Element* a = document->root()->select_one("#a");
+    Element* b = document->root()->select_one("#b");
+
+    // Descendants take precedence over their ancestors.
+    ASSERT_NE(-1, tree.box_at(40, 20));
+    EXPECT_EQ(b, tree.boxes()[tree.box_at(40, 20)].element);
+    EXPECT_EQ(a, tree.boxes()[tree.box_at(150, 80)].element);
+
+    // Hidden elements aren't hit, but their visible descendants are.
+    Element* inline_block = document->root()->select_one("b");
+    ASSERT_NE(-1, tree.box_at(5, 125));
+    EXPECT_EQ(inline_block, tree.boxes()[tree.box_at(5, 125)].element);
+    EXPECT_NE(document->root()->select_one("#d"),
+        tree.boxes()[tree.box_at(400, 160)].element);
+
+    std::vector<int> result;
+    tree.intersecting(Position(25, 5, 10, 10), result);
+    std::vector<Element*> elements;
+    for (int i : result) {
+        elements.push_back(tree.boxes()[i].element);
+    }
+    EXPECT_NE(elements.end(), std::find(elements.begin(), elements.end(), a));
+    EXPECT_NE(elements.end(), std::find(elements.begin(), elements.end(), b));
+    EXPECT_EQ(elements.end(),
+        std::find(elements.begin(), elements.end(), inline_block));
+
+    delete document;
+}
@@ -40,12 +40,25 @@ void litehtml::table_grid::add_cell(Element::ptr& el)
     cell.el = el;
     cell.colspan = atoi(el->get_attr("colspan", "1"));
     cell.rowspan = atoi(el->get_attr("rowspan", "1"));
+
+    // Clamp rowspan the way HTML does, so the last spanned row can't
+    // overflow.
+    cell.rowspan = std::min(cell.rowspan, 65534);
     cell.borders = el->border();
 
     while (is_rowspanned((int)m_cells.size() - 1, (int)m_cells.back().size())) {
         m_cells.back().push_back(table_cell());
     }
 
+    if (cell.rowspan > 1) {
+        size_t col = m_cells.back().size();
+        if (m_rowspan_end.size() <= col) {
+            m_rowspan_end.resize(col + 1, -1);
+        }
+        m_rowspan_end[col] = std::max(m_rowspan_end[col],
+            (int)m_cells.size() - 1 + cell.rowspan - 1);
+    }
+
     m_cells.back().push_back(cell);
     for (int i = 1; i < cell.colspan; i++) {
         table_cell empty_cell;
@@ -65,16 +78,7 @@ void litehtml::table_grid::begin_row(Element::ptr& row)
 
 bool litehtml::table_grid::is_rowspanned(int r, int c)
 {
-    for (int row = r - 1; row >= 0; row--) {
-        if (c < (int)m_cells[row].size()) {
-            if (m_cells[row][c].rowspan > 1) {
-                if (m_cells[row][c].rowspan >= r - row + 1) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    return c < (int)m_rowspan_end.size() && m_rowspan_end[c] >= r;
 }
 
 void litehtml::table_grid::finish()
@@ -136,6 +140,10 @@ void litehtml::table_grid::finish()
                     m_columns[col].css_width.is_predefined()) {
                     m_columns[col].css_width = cell(col, row)->el->get_css_width();
                 }
+                if (row == 0) {
+                    m_columns[col].fixed_css_width =
+                        cell(col, row)->el->get_css_width();
+                }
             }
         }
     }
@@ -159,20 +167,18 @@ litehtml::table_cell* litehtml::table_grid::cell(int t_col, int t_row)
 
 void litehtml::table_grid::distribute_max_width(int width, int start, int end)
 {
-    table_column_accessor_max_width selector;
-    distribute_width(width, start, end, &selector);
+    distribute_width(width, start, end, &table_column::max_width);
 }
 
 void litehtml::table_grid::distribute_min_width(int width, int start, int end)
 {
-    table_column_accessor_min_width selector;
-    distribute_width(width, start, end, &selector);
+    distribute_width(width, start, end, &table_column::min_width);
 }
 
 void litehtml::table_grid::distribute_width(int width,
     int start,
     int end,
-    table_column_accessor* acc)
+    int table_column::*member)
 {
     if (!(start >= 0 && start < m_cols_count && end >= 0 && end < m_cols_count)) {
         return;
@@ -191,10 +197,10 @@ void litehtml::table_grid::distribute_width(int width,
                           ((float)m_columns[col].max_width / (float)cols_width));
         }
         added_width += add;
-        acc->get(m_columns[col]) += add;
+        m_columns[col].*member += add;
     }
     if (added_width < width) {
-        acc->get(m_columns[start]) += width - added_width;
+        m_columns[start].*member += width - added_width;
     }
 }
 
@@ -366,11 +372,50 @@ int litehtml::table_grid::calc_table_width(int block_width,
     return cur_width;
 }
 
+int litehtml::table_grid::calc_fixed_table_width(int block_width)
+{
+    int cur_width = 0;
+    int auto_count = 0;
+
+    for (int col = 0; col < m_cols_count; col++) {
+        if (!m_columns[col].fixed_css_width.is_predefined()) {
+            m_columns[col].width =
+                std::max(m_columns[col].fixed_css_width.calc_percent(block_width), 0);
+            cur_width += m_columns[col].width;
+        } else {
+            m_columns[col].width = 0;
+            auto_count++;
+        }
+    }
+
+    // Share the remaining width equally between the columns with width ==
+    // auto, or between all the columns if there are none.
+    if (cur_width < block_width && m_cols_count) {
+        bool all = auto_count == 0;
+        int count = all ? m_cols_count : auto_count;
+        int add = (block_width - cur_width) / count;
+        int rest = (block_width - cur_width) - add * count;
+        for (int col = 0; col < m_cols_count; col++) {
+            if (all || m_columns[col].fixed_css_width.is_predefined()) {
+                m_columns[col].width += add + rest;
+                cur_width += add + rest;
+                rest = 0;
+            }
+        }
+    }
+
+    for (int col = 0; col < m_cols_count; col++) {
+        m_columns[col].min_width = m_columns[col].max_width = m_columns[col].width;
+    }
+    return cur_width;
+}
+
 void litehtml::table_grid::clear()
 {
     m_rows_count = 0;
     m_cols_count = 0;
     m_cells.clear();
+    m_rowspan_end.clear();
     m_columns.clear();
     m_rows.clear();
 }
@@ -507,25 +552,4 @@ void litehtml::table_grid::calc_rows_height(int blockHeight, int /* borderSpacin
     }
 }
 
-//////////////////////////////////////////////////////////////////////////
-
-litehtml::table_column_accessor::~table_column_accessor()
-{
-}
-
-int& litehtml::table_column_accessor_max_width::get(table_column& col)
-{
-    return col.max_width;
-}
-
-int& litehtml::table_column_accessor_min_width::get(table_column& col)
-{
-    return col.min_width;
-}
-
-int& litehtml::table_column_accessor_width::get(table_column& col)
-{
-    return col.width;
-}
-
 } // namespace litehtml
@@ -29,7 +29,80 @@
 
 #include "litehtml/text.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace litehtml {
 
+namespace {
+
+#if defined(__SSE2__)
+
+// Returns a 16-bit mask with bit i set if byte i of the 16 bytes at p is a
+// whitespace character (see is_whitespace()).
+inline unsigned whitespace_mask(const char* p)
+{
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+    __m128i ws = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\f')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')));
+
+    return static_cast<unsigned>(_mm_movemask_epi8(ws));
+}
+
+#endif
+
+inline bool is_whitespace_byte(char c)
+{
+    return is_whitespace(static_cast<unsigned char>(c));
+}
+
+} // namespace
+
+const char* find_whitespace(const char* begin, const char* end)
+{
+    const char* p = begin;
+
+    // Text shorter than a vector (most words and the spaces between them)
+    // is only scanned by the loop at the end.
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        unsigned mask = whitespace_mask(p);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+
+    while (p != end && !is_whitespace_byte(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char* find_non_whitespace(const char* begin, const char* end)
+{
+    const char* p = begin;
+
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        unsigned mask = whitespace_mask(p) ^ 0xffff;
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+
+    while (p != end && is_whitespace_byte(*p)) {
+        p++;
+    }
+    return p;
+}
 
 } // namespace litehtml
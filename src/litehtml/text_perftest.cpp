@@ -0,0 +1,195 @@
+// Copyright (C) 2020-2021 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the names of the copyright holders nor the names of their
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "litehtml/text.h"
+
+using namespace litehtml;
+
+namespace {
+
+std::string load(const std::string& filename)
+{
+    std::ifstream ifs(filename.c_str());
+
+    if (ifs.bad()) {
+        assert(false);
+    }
+
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+    return buffer.str();
+}
+
+// The pages the benchmarks segment (selected by the benchmark argument).
+const char* const kCorpus[] = {
+    "../test/html/obama.html",
+    "../test/render/html/hipster-ipsum.html",
+    "../test/render/html/rtl-hebrew.html",
+    "../test/render/html/rtl-persian.html",
+};
+
+const int kCorpusSize = sizeof(kCorpus) / sizeof(kCorpus[0]);
+
+// Returns the text between the tags in html, one string per text node, as
+// split_text_node() sees it (without decoding character references).
+std::vector<std::string> text_nodes(const std::string& html)
+{
+    std::vector<std::string> nodes;
+    size_t begin = html.find('>');
+    while (begin != std::string::npos) {
+        size_t end = html.find('<', begin + 1);
+        if (end == std::string::npos) {
+            break;
+        }
+        if (end != begin + 1) {
+            nodes.push_back(html.substr(begin + 1, end - begin - 1));
+        }
+        begin = html.find('>', end);
+    }
+    return nodes;
+}
+
+} // namespace
+
+// Segment text into whitespace and non-whitespace runs one byte at a time.
+void TextPerfTestSegmentScalar(benchmark::State& state)
+{
+    std::string text = load(kCorpus[state.range(0)]);
+    const char* end = text.data() + text.size();
+
+    for (auto _ : state) {
+        size_t runs = 0;
+        bool in_whitespace = false;
+        const char* p = text.data();
+        while (p != end) {
+            bool whitespace = is_whitespace(static_cast<unsigned char>(*p++));
+            if (whitespace != in_whitespace) {
+                runs++;
+                in_whitespace = whitespace;
+            }
+        }
+        benchmark::DoNotOptimize(runs);
+    }
+
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetLabel(kCorpus[state.range(0)]);
+}
+
+BENCHMARK(TextPerfTestSegmentScalar)->DenseRange(0, kCorpusSize - 1);
+
+// Segment text into whitespace and non-whitespace runs using
+// find_whitespace() and find_non_whitespace().
+void TextPerfTestSegment(benchmark::State& state)
+{
+    std::string text = load(kCorpus[state.range(0)]);
+    const char* end = text.data() + text.size();
+
+    for (auto _ : state) {
+        size_t runs = 0;
+        const char* p = text.data();
+        while (p != end) {
+            p = find_whitespace(p, end);
+            p = find_non_whitespace(p, end);
+            runs++;
+        }
+        benchmark::DoNotOptimize(runs);
+    }
+
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetLabel(kCorpus[state.range(0)]);
+}
+
+BENCHMARK(TextPerfTestSegment)->DenseRange(0, kCorpusSize - 1);
+
+void TextPerfTestSplitScalar(benchmark::State& state)
+{
+    std::vector<std::string> nodes = text_nodes(load(kCorpus[state.range(0)]));
+    size_t bytes = 0;
+    for (auto& node : nodes) {
+        bytes += node.size();
+    }
+
+    for (auto _ : state) {
+        size_t runs = 0;
+        for (auto& node : nodes) {
+            bool in_whitespace = false;
+            const char* p = node.data();
+            const char* end = p + node.size();
+            while (p != end) {
+                bool whitespace = is_whitespace(static_cast<unsigned char>(*p++));
+                if (whitespace != in_whitespace) {
+                    runs++;
+                    in_whitespace = whitespace;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(runs);
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetLabel(kCorpus[state.range(0)]);
+}
+
+BENCHMARK(TextPerfTestSplitScalar)->DenseRange(0, kCorpusSize - 1);
+
+void TextPerfTestSplit(benchmark::State& state)
+{
+    std::vector<std::string> nodes = text_nodes(load(kCorpus[state.range(0)]));
+    size_t bytes = 0;
+    for (auto& node : nodes) {
+        bytes += node.size();
+    }
+
+    for (auto _ : state) {
+        size_t runs = 0;
+        for (auto& node : nodes) {
+            const char* p = node.data();
+            const char* end = p + node.size();
+            while (p != end) {
+                p = find_whitespace(p, end);
+                p = find_non_whitespace(p, end);
+                runs++;
+            }
+        }
+        benchmark::DoNotOptimize(runs);
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetLabel(kCorpus[state.range(0)]);
+}
+
+BENCHMARK(TextPerfTestSplit)->DenseRange(0, kCorpusSize - 1);
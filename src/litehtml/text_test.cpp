@@ -42,3 +42,42 @@ TEST(TextTest, Whitespace)
   EXPECT_TRUE(is_whitespace('\r'));
   EXPECT_TRUE(is_whitespace('\n'));
 }
+
+TEST(TextTest, FindWhitespace)
+{
+    // Use strings longer than 16 bytes so the vectorized path (if any) is
+    // exercised along with the scalar tail.
+    std::string text = "abcdefghijklmnopqrstuvwxyz \t\r\n\fABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+
+    EXPECT_EQ(begin + 26, find_whitespace(begin, end));
+    EXPECT_EQ(begin + 31, find_non_whitespace(begin + 26, end));
+    EXPECT_EQ(end, find_whitespace(begin + 31, end));
+    EXPECT_EQ(begin, find_non_whitespace(begin, end));
+    EXPECT_EQ(end, find_whitespace(end, end));
+    EXPECT_EQ(end, find_non_whitespace(end, end));
+
+    std::string spaces(40, ' ');
+    EXPECT_EQ(spaces.data() + spaces.size(),
+        find_non_whitespace(spaces.data(), spaces.data() + spaces.size()));
+
+    // Vertical tab is not whitespace.
+    std::string vtab = "\v";
+    EXPECT_EQ(vtab.data() + 1, find_whitespace(vtab.data(), vtab.data() + 1));
+}
+
+TEST(TextTest, FindWhitespaceNonASCII)
+{
+    // U+00A0 (no-break space) and U+3000 (ideographic space) are not
+    // whitespace according to is_whitespace().
+    std::string text = "\xc3\xa9t\xc3\xa9\xc2\xa0\xe3\x80\x80\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xa7\xe3\x81\x99 end";
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+
+    const char* space = find_whitespace(begin, end);
+    ASSERT_NE(end, space);
+    EXPECT_EQ(' ', *space);
+    EXPECT_EQ(text.find(' '), static_cast<size_t>(space - begin));
+    EXPECT_EQ(space + 1, find_non_whitespace(space, end));
+}
@@ -0,0 +1,171 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/text_width_cache.h"
+
+#include <vector>
+
+#include "litehtml/document_container.h"
+
+namespace litehtml {
+
+TextWidthCache::TextWidthCache(size_t capacity)
+: capacity_(capacity)
+{
+}
+
+bool TextWidthCache::find(const Key& key, int& width)
+{
+    auto entry = widths_.find(key);
+    if (entry == widths_.end()) {
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, entry->second.lru);
+    width = entry->second.width;
+    return true;
+}
+
+void TextWidthCache::add(const Key& key, int width)
+{
+    // Another thread may have measured the same text in the meantime.
+    if (widths_.count(key)) {
+        return;
+    }
+
+    while (!lru_.empty() && widths_.size() >= capacity_) {
+        widths_.erase(lru_.back());
+        lru_.pop_back();
+        stats_.evictions++;
+    }
+
+    lru_.push_front(key);
+    Entry& entry = widths_[key];
+    entry.width = width;
+    entry.lru = lru_.begin();
+}
+
+int TextWidthCache::text_width(DocumentContainer* container,
+    const char* text,
+    uintptr_t font)
+{
+    Key key{font, text};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int width;
+        if (find(key, width)) {
+            stats_.hits++;
+            return width;
+        }
+        stats_.misses++;
+    }
+
+    // Measure without holding the lock, so other threads can look up widths
+    // in the meantime.
+    int width = container->text_width(text, font);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(key, width);
+    return width;
+}
+
+void TextWidthCache::measure_texts(DocumentContainer* container,
+    const TextRun* runs,
+    size_t count,
+    int* widths)
+{
+    const size_t kCached = (size_t)-1;
+
+    // The runs the container needs to measure, and for each run, the index
+    // of its width in the measured widths (or kCached if the width is
+    // already known).
+    std::vector<TextRun> missing;
+    std::unordered_map<Key, size_t, KeyHash> missing_index;
+    std::vector<size_t> sources(count, kCached);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < count; i++) {
+            Key key{runs[i].font, runs[i].text};
+            if (find(key, widths[i])) {
+                stats_.hits++;
+                continue;
+            }
+
+            auto index = missing_index.emplace(std::move(key), missing.size());
+            if (index.second) {
+                stats_.misses++;
+                missing.push_back(runs[i]);
+            } else {
+                stats_.hits++;
+            }
+            sources[i] = index.first->second;
+        }
+    }
+
+    if (missing.empty()) {
+        return;
+    }
+
+    std::vector<int> measured(missing.size());
+    container->measure_texts(missing.data(), missing.size(), measured.data());
+
+    for (size_t i = 0; i < count; i++) {
+        if (sources[i] != kCached) {
+            widths[i] = measured[sources[i]];
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& index : missing_index) {
+        add(index.first, measured[index.second]);
+    }
+}
+
+void TextWidthCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    widths_.clear();
+    lru_.clear();
+    stats_ = Stats();
+}
+
+size_t TextWidthCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return widths_.size();
+}
+
+TextWidthCache::Stats TextWidthCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace litehtml
@@ -0,0 +1,198 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/text_width_cache.h"
+
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "litehtml/context.h"
+#include "litehtml/document.h"
+#include "litehtml/document_container.h"
+#include "litehtml/document_parser.h"
+#include "test_container.h"
+
+using namespace litehtml;
+
+namespace {
+
+// A container that counts the strings it measures, and the batches it
+// measures them in.
+class counting_container : public test_container {
+public:
+    int calls = 0;
+    int batches = 0;
+
+    virtual int text_width(const char* text, uintptr_t font) override
+    {
+        calls++;
+        return (int)strlen(text) * 8 + (int)font;
+    }
+
+    virtual void measure_texts(const TextRun* runs,
+        size_t count,
+        int* widths) override
+    {
+        batches++;
+        test_container::measure_texts(runs, count, widths);
+    }
+};
+
+} // namespace
+
+TEST(TextWidthCacheTest, TextWidth)
+{
+    counting_container container;
+    TextWidthCache cache;
+
+    EXPECT_EQ(24, cache.text_width(&container, "the", 0));
+    EXPECT_EQ(24, cache.text_width(&container, "the", 0));
+    EXPECT_EQ(25, cache.text_width(&container, "the", 1));
+    EXPECT_EQ(24, cache.text_width(&container, "and", 0));
+    EXPECT_EQ(25, cache.text_width(&container, "the", 1));
+
+    EXPECT_EQ(3, container.calls);
+    EXPECT_EQ(2u, cache.stats().hits);
+    EXPECT_EQ(3u, cache.stats().misses);
+    EXPECT_EQ(3u, cache.size());
+
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.stats().hits);
+    EXPECT_EQ(24, cache.text_width(&container, "the", 0));
+    EXPECT_EQ(4, container.calls);
+}
+
+TEST(TextWidthCacheTest, Capacity)
+{
+    counting_container container;
+    TextWidthCache cache(4);
+    EXPECT_EQ(4u, cache.capacity());
+
+    for (int i = 0; i < 100; i++) {
+        std::string text = std::to_string(i);
+        EXPECT_EQ((int)text.size() * 8, cache.text_width(&container, text.c_str(), 0));
+        EXPECT_LE(cache.size(), 4u);
+    }
+    EXPECT_EQ(100, container.calls);
+    EXPECT_EQ(96u, cache.stats().evictions);
+}
+
+TEST(TextWidthCacheTest, LeastRecentlyUsed)
+{
+    counting_container container;
+    TextWidthCache cache(3);
+
+    cache.text_width(&container, "a", 0);
+    cache.text_width(&container, "b", 0);
+    cache.text_width(&container, "c", 0);
+
+    // Using "a" again keeps it when "d" needs room; "b" is dropped instead.
+    cache.text_width(&container, "a", 0);
+    cache.text_width(&container, "d", 0);
+    EXPECT_EQ(4, container.calls);
+
+    cache.text_width(&container, "a", 0);
+    cache.text_width(&container, "c", 0);
+    cache.text_width(&container, "d", 0);
+    EXPECT_EQ(4, container.calls);
+
+    cache.text_width(&container, "b", 0);
+    EXPECT_EQ(5, container.calls);
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_EQ(2u, cache.stats().evictions);
+}
+
+TEST(TextWidthCacheTest, MeasureTexts)
+{
+    counting_container container;
+    TextWidthCache cache;
+
+    EXPECT_EQ(24, cache.text_width(&container, "the", 0));
+
+    TextRun runs[] = {
+        {"the", 0},
+        {"cat", 0},
+        {"the", 1},
+        {"cat", 0},
+        {"the", 0},
+    };
+    int widths[5] = {};
+    cache.measure_texts(&container, runs, 5, widths);
+
+    EXPECT_EQ(24, widths[0]);
+    EXPECT_EQ(24, widths[1]);
+    EXPECT_EQ(25, widths[2]);
+    EXPECT_EQ(24, widths[3]);
+    EXPECT_EQ(24, widths[4]);
+
+    // Only the runs that weren't cached are measured, in one batch and each
+    // once.
+    EXPECT_EQ(1, container.batches);
+    EXPECT_EQ(3, container.calls);
+    EXPECT_EQ(3u, cache.stats().misses);
+    EXPECT_EQ(3u, cache.stats().hits);
+
+    // Batches of cached runs don't reach the container.
+    cache.measure_texts(&container, runs, 5, widths);
+    EXPECT_EQ(1, container.batches);
+    EXPECT_EQ(25, widths[2]);
+}
+
+TEST(TextWidthCacheTest, Document)
+{
+    std::string html = "<html><body><p>";
+    for (int i = 0; i < 100; i++) {
+        html += "the cat and the dog ";
+    }
+    html += "</p></body></html>";
+
+    Context context;
+    counting_container container;
+    Document* document = DocumentParser::parse(html, URL(), &container, &context);
+
+    TextWidthCache::Stats stats = document->text_width_cache().stats();
+    EXPECT_EQ(1, container.batches);
+#if defined(USE_ICU)
+    // Every word (with the space after it) is measured once, all in one
+    // batch.
+    EXPECT_EQ(4, container.calls);
+    EXPECT_EQ(4u, stats.misses);
+    EXPECT_EQ(500u - 4u, stats.hits);
+#else
+    // Every word and space is measured once, all in one batch.
+    EXPECT_EQ(5, container.calls);
+    EXPECT_EQ(5u, stats.misses);
+    EXPECT_EQ(1000u - 5u, stats.hits);
+#endif
+
+    delete document;
+}
@@ -0,0 +1,122 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/thread_pool.h"
+
+namespace litehtml {
+
+namespace {
+
+// Set while the thread runs the iterations of a loop.
+thread_local bool in_loop = false;
+
+} // namespace
+
+ThreadPool::ThreadPool(int threads)
+: next_(0)
+{
+    for (int i = 1; i < threads; i++) {
+        threads_.emplace_back(&ThreadPool::worker, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count,
+    const std::function<void(size_t)>& fn)
+{
+    if (threads_.empty() || count < 2 || in_loop) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fn_ = &fn;
+        count_ = count;
+        next_ = 0;
+        busy_ = (int)threads_.size();
+        loop_++;
+    }
+    start_.notify_all();
+
+    run();
+
+    // Every worker takes part in every loop (if only to find that there are
+    // no iterations left), so the next loop can't start before they're done.
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_ == 0; });
+    fn_ = nullptr;
+}
+
+void ThreadPool::run()
+{
+    in_loop = true;
+    for (size_t i = next_++; i < count_; i = next_++) {
+        (*fn_)(i);
+    }
+    in_loop = false;
+}
+
+void ThreadPool::worker()
+{
+    unsigned long loop = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        start_.wait(lock, [&] { return stop_ || loop_ != loop; });
+        if (stop_) {
+            return;
+        }
+        loop = loop_;
+
+        lock.unlock();
+        run();
+        lock.lock();
+
+        if (--busy_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+} // namespace litehtml
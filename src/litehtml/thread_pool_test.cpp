@@ -0,0 +1,73 @@
+// Copyright (C) 2020-2022 Primate Labs Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//    * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//    * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//    * Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "litehtml/thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace litehtml;
+
+TEST(ThreadPoolTest, ParallelFor)
+{
+  ThreadPool pool(4);
+  EXPECT_EQ(4, pool.threads());
+
+  for (size_t count : {0, 1, 2, 3, 100, 1000}) {
+    std::vector<int> calls(count, 0);
+    pool.parallel_for(count, [&](size_t i) { calls[i]++; });
+    for (size_t i = 0; i < count; i++) {
+      EXPECT_EQ(1, calls[i]);
+    }
+  }
+}
+
+TEST(ThreadPoolTest, Nested)
+{
+  ThreadPool pool(3);
+
+  std::atomic<int> total(0);
+  pool.parallel_for(10, [&](size_t) {
+    pool.parallel_for(10, [&](size_t i) { total += (int)i; });
+  });
+  EXPECT_EQ(450, total);
+}
+
+TEST(ThreadPoolTest, SingleThread)
+{
+  ThreadPool pool(1);
+  EXPECT_EQ(1, pool.threads());
+
+  std::vector<size_t> order;
+  pool.parallel_for(5, [&](size_t i) { order.push_back(i); });
+  EXPECT_EQ((std::vector<size_t>{0, 1, 2, 3, 4}), order);
+}
@@ -55,6 +55,24 @@ def run_headless(headless_executable, html_path, output_path):
         subprocess.run(cmd, check=True)
 
 
+def benchmark_headless(headless_executable, html_path, iterations):
+    html_files = glob.glob(os.path.join(html_path, '*.html'))
+
+    with tempfile.TemporaryDirectory() as output_path:
+        for html_file in sorted(html_files):
+            html_filename = pathlib.Path(html_file).name
+            png_filename = pathlib.Path(html_filename).with_suffix('.png')
+
+            cmd = [
+                headless_executable,
+                '--file', html_file,
+                '--output', os.path.join(output_path, png_filename),
+                '--iterations', str(iterations)
+            ]
+            print(html_filename, flush=True)
+            subprocess.run(cmd, check=True)
+
+
 def compare_images(output_path, reference_path):
     status = 0
     png_files = glob.glob(os.path.join(output_path, '*.png'))
@@ -83,7 +101,9 @@ def argument_parser():
 
     parser.add_argument('--html-path', required=True)
 
-    parser.add_argument('--reference-path', required=True)
+    parser.add_argument('--reference-path')
+
+    parser.add_argument('--iterations', type=int, default=100)
 
     return parser
 
@@ -94,6 +114,9 @@ def main():
 
     status = 0
 
+    if args.action in ('test', 'regenerate') and not args.reference_path:
+        parser.error('--reference-path is required')
+
     if args.action == 'test':
         tmp_path = '/tmp'
         run_headless(args.headless_executable,
@@ -107,6 +130,11 @@ def main():
             args.html_path,
             args.reference_path)
 
+    if args.action == 'benchmark':
+        benchmark_headless(args.headless_executable,
+            args.html_path,
+            args.iterations)
+
     # sys.exit() only handles values between 0 and 127. Python documentation
     # states that behaviour for values outside of this range may be undefined,
     # but in our experience values are masked against 0x7f. Values that mask to